@@ -0,0 +1,45 @@
+#version 430 core
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 normal;
+layout (location = 2) in vec3 color;
+layout (location = 3) in vec2 texCoords;
+layout (location = 12) in uint instanceId;
+
+out vec3 FragmentPos;
+smooth out vec3 Normal;
+out vec3 Color;
+out vec2 TexCoords;
+
+layout (std140) uniform Frame
+{
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos;
+};
+
+struct Instance
+{
+    mat4 model;
+    mat3 normal;
+    vec4 center;
+    vec3 extents;
+    uint command;
+};
+
+layout (std430, binding = 1) readonly buffer Instances
+{
+    Instance instances[];
+};
+
+void main()
+{
+    Instance instance = instances[instanceId];
+
+    FragmentPos = vec3(instance.model * vec4(position, 1.0));
+    Normal = instance.normal * normal;
+    Color = color;
+    TexCoords = texCoords;
+
+    gl_Position = projection * view * vec4(FragmentPos, 1.0);
+}
@@ -0,0 +1,105 @@
+#version 430 core
+
+layout (local_size_x = 64) in;
+
+struct Instance
+{
+    mat4 model;
+    mat3 normal;
+    vec4 center;
+    vec3 extents;
+    uint command;
+};
+
+struct Command
+{
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    int baseVertex;
+    uint baseInstance;
+};
+
+layout (std430, binding = 1) readonly buffer Instances
+{
+    Instance instances[];
+};
+
+layout (std430, binding = 2) buffer Commands
+{
+    Command commands[];
+};
+
+layout (std430, binding = 3) writeonly buffer Visible
+{
+    uint visible[];
+};
+
+layout (binding = 0) uniform sampler2D pyramid;
+
+uniform uint instanceCount;
+uniform vec4 planes[6];
+uniform bool occlusion;
+uniform mat4 pyramidViewProjection;
+
+bool insideFrustum(vec3 center, vec3 extents)
+{
+    for (int i = 0; i < 6; ++i)
+        if (dot(planes[i].xyz, center) + dot(abs(planes[i].xyz), extents) + planes[i].w < 0.0) return false;
+
+    return true;
+}
+
+bool occluded(vec3 center, vec3 extents)
+{
+    vec2 minimum = vec2(1.0), maximum = vec2(0.0);
+    float nearest = 1.0;
+
+    for (int i = 0; i < 8; ++i)
+    {
+        vec3 corner = center + extents * vec3((i & 1) != 0 ? 1.0 : -1.0, (i & 2) != 0 ? 1.0 : -1.0,
+                                              (i & 4) != 0 ? 1.0 : -1.0);
+        vec4 clip = pyramidViewProjection * vec4(corner, 1.0);
+        if (clip.w <= 0.0) return false;
+
+        vec3 ndc = clip.xyz / clip.w * 0.5 + 0.5;
+        minimum = min(minimum, ndc.xy);
+        maximum = max(maximum, ndc.xy);
+        nearest = min(nearest, ndc.z);
+    }
+
+    minimum = clamp(minimum, 0.0, 1.0);
+    maximum = clamp(maximum, 0.0, 1.0);
+
+    vec2 size = (maximum - minimum) * vec2(textureSize(pyramid, 0));
+    int level = clamp(int(ceil(log2(max(max(size.x, size.y), 1.0)))), 0, textureQueryLevels(pyramid) - 1);
+
+    // Odd rows and columns fold into the last texel of each level, so map through level 0 pixels.
+    ivec2 baseSize = textureSize(pyramid, 0), levelSize = textureSize(pyramid, level);
+    ivec2 first = min(min(ivec2(minimum * vec2(baseSize)), baseSize - 1) >> level, levelSize - 1);
+    ivec2 last = min(min(ivec2(maximum * vec2(baseSize)), baseSize - 1) >> level, levelSize - 1);
+
+    float farthest = max(max(texelFetch(pyramid, first, level).r, texelFetch(pyramid, ivec2(last.x, first.y), level).r),
+                         max(texelFetch(pyramid, ivec2(first.x, last.y), level).r, texelFetch(pyramid, last, level).r));
+
+    return nearest > farthest;
+}
+
+void main()
+{
+    uint id = gl_GlobalInvocationID.x;
+    if (id >= instanceCount) return;
+
+    Instance instance = instances[id];
+    mat3 model = mat3(instance.model);
+
+    vec3 center = vec3(instance.model * vec4(instance.center.xyz, 1.0));
+    vec3 extents = abs(model[0]) * instance.extents.x + abs(model[1]) * instance.extents.y +
+                   abs(model[2]) * instance.extents.z;
+
+    if (!insideFrustum(center, extents)) return;
+    if (occlusion && occluded(center, extents)) return;
+
+    uint slot = atomicAdd(commands[instance.command].instanceCount, 1u);
+    visible[commands[instance.command].baseInstance + slot] = id;
+}
@@ -10,19 +10,27 @@ in vec2 TexCoords;
 uniform sampler2D texture_diffuse1;
 uniform sampler2D texture_specular1;
 
-uniform vec3 lightColor;
-uniform vec3 lightPos;
-uniform vec3 lightDirection;
-
-uniform vec3 viewPos;
-uniform vec3 objectColor;
-uniform int lightType;
-uniform float spotLightAngle;
-uniform float shininess = 32.0;
+layout (std140) uniform Frame
+{
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos;
+};
 
-uniform bool enableAmbientLight;
-uniform bool enableDiffuseLight;
-uniform bool enableSpecularLight;
+layout (std140) uniform Light
+{
+    vec4 lightPos;
+    vec4 lightDirection;
+    vec4 lightColor;
+    int lightType;
+    float spotLightAngle;
+    bool enableAmbientLight;
+    bool enableDiffuseLight;
+    bool enableSpecularLight;
+};
+
+uniform vec3 objectColor = vec3(1.0);
+uniform float shininess = 32.0;
 uniform bool hasTexture;
 
 uniform float ambientStrength = 0.1;
@@ -32,30 +40,30 @@ uniform float quadraticIntensity = 0.032;
 
 vec3 calculateAmbientLight()
 {
-    return enableAmbientLight ? ambientStrength * lightColor : vec3(0.0);
+    return enableAmbientLight ? ambientStrength * lightColor.rgb : vec3(0.0);
 }
 
 vec3 calculateDiffuseLight(vec3 lightPosition)
 {
-    return enableDiffuseLight ? max(dot(Normal, normalize(lightPosition - FragmentPos)), 0.0) * lightColor : vec3(0.0);
+    return enableDiffuseLight ? max(dot(Normal, normalize(lightPosition - FragmentPos)), 0.0) * lightColor.rgb : vec3(0.0);
 }
 
 vec3 calculateSpecularLight(vec3 lightPosition)
 {
-    vec3 viewDir = normalize(viewPos - FragmentPos);
+    vec3 viewDir = normalize(viewPos.xyz - FragmentPos);
     vec3 lightDir = normalize(lightPosition - FragmentPos);
     vec3 reflectDir = reflect(-lightDir, Normal);
 
-    return enableSpecularLight ? specularStrength * pow(max(dot(viewDir, reflectDir), 0.0), shininess) * lightColor : vec3(0.0);
+    return enableSpecularLight ? specularStrength * pow(max(dot(viewDir, reflectDir), 0.0), shininess) * lightColor.rgb : vec3(0.0);
 }
 
 void pointLight()
 {
     vec3 ambient = calculateAmbientLight();
-    vec3 diffuse = calculateDiffuseLight(lightPos);
-    vec3 specular = calculateSpecularLight(lightPos);
+    vec3 diffuse = calculateDiffuseLight(lightPos.xyz);
+    vec3 specular = calculateSpecularLight(lightPos.xyz);
 
-    float distance = length(lightPos - FragmentPos);
+    float distance = length(lightPos.xyz - FragmentPos);
     float intensity = 1.0 / (1.0 + linearIntensity * distance + quadraticIntensity * (distance * distance));
 
     vec3 diffuseTex = hasTexture ? texture(texture_diffuse1, TexCoords).rgb * (ambient + diffuse) : objectColor * (ambient + diffuse);
@@ -81,11 +89,11 @@ void spotLight()
     float outerCone = cos(radians(spotLightAngle)), innerCone = cos(radians(spotLightAngle - 7.5));
 
     vec3 ambient = calculateAmbientLight();
-    vec3 diffuse = calculateDiffuseLight(lightPos);
-    vec3 specular = calculateSpecularLight(lightPos);
+    vec3 diffuse = calculateDiffuseLight(lightPos.xyz);
+    vec3 specular = calculateSpecularLight(lightPos.xyz);
 
-    vec3 lightDir = normalize(lightPos - FragmentPos);
-    float theta = dot(lightDir, normalize(-lightDirection));
+    vec3 lightDir = normalize(lightPos.xyz - FragmentPos);
+    float theta = dot(lightDir, normalize(-lightDirection.xyz));
 
     float intensity = clamp((theta - outerCone) / (innerCone - outerCone), 0.0, 1.0);
 
@@ -10,9 +10,14 @@ smooth out vec3 Normal;
 out vec3 Color;
 out vec2 TexCoords;
 
+layout (std140) uniform Frame
+{
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos;
+};
+
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
 
 void main()
 {
@@ -0,0 +1,31 @@
+#version 430 core
+
+layout (local_size_x = 8, local_size_y = 8) in;
+
+layout (binding = 0) uniform sampler2D source;
+layout (r32f, binding = 0) writeonly uniform image2D destination;
+
+uniform int sourceLevel;
+uniform int scale;
+
+void main()
+{
+    ivec2 coord = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 destinationSize = imageSize(destination);
+    if (any(greaterThanEqual(coord, destinationSize))) return;
+
+    ivec2 sourceSize = textureSize(source, sourceLevel);
+    ivec2 first = coord * scale;
+    ivec2 last = first + ivec2(scale - 1);
+
+    // Odd source sizes leave a row or column that only the last destination texel can cover.
+    if (coord.x == destinationSize.x - 1) last.x = sourceSize.x - 1;
+    if (coord.y == destinationSize.y - 1) last.y = sourceSize.y - 1;
+
+    float farthest = 0.0;
+    for (int y = first.y; y <= last.y; ++y)
+        for (int x = first.x; x <= last.x; ++x)
+            farthest = max(farthest, texelFetch(source, ivec2(x, y), sourceLevel).r);
+
+    imageStore(destination, coord, vec4(farthest));
+}
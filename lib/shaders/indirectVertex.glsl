@@ -0,0 +1,42 @@
+#version 430 core
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 normal;
+layout (location = 2) in vec3 color;
+layout (location = 3) in vec2 texCoords;
+layout (location = 11) in uint drawId;
+
+out vec3 FragmentPos;
+smooth out vec3 Normal;
+out vec3 Color;
+out vec2 TexCoords;
+
+layout (std140) uniform Frame
+{
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos;
+};
+
+struct Draw
+{
+    mat4 model;
+    mat3 normal;
+};
+
+layout (std430, binding = 0) readonly buffer Draws
+{
+    Draw draws[];
+};
+
+void main()
+{
+    Draw draw = draws[drawId];
+
+    FragmentPos = vec3(draw.model * vec4(position, 1.0));
+    Normal = draw.normal * normal;
+    Color = color;
+    TexCoords = texCoords;
+
+    gl_Position = projection * view * vec4(FragmentPos, 1.0);
+}
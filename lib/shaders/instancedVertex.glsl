@@ -0,0 +1,30 @@
+#version 330 core
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec3 normal;
+layout (location = 2) in vec3 color;
+layout (location = 3) in vec2 texCoords;
+layout (location = 4) in mat4 instanceModel;
+layout (location = 8) in mat3 instanceNormal;
+
+out vec3 FragmentPos;
+smooth out vec3 Normal;
+out vec3 Color;
+out vec2 TexCoords;
+
+layout (std140) uniform Frame
+{
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos;
+};
+
+void main()
+{
+    FragmentPos = vec3(instanceModel * vec4(position, 1.0));
+    Normal = instanceNormal * normal;
+    Color = color;
+    TexCoords = texCoords;
+
+    gl_Position = projection * view * vec4(FragmentPos, 1.0);
+}
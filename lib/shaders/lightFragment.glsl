@@ -1,7 +1,18 @@
 #version 330 core
 
 out vec4 FragColor;
-uniform vec4 lightColor;
+
+layout (std140) uniform Light
+{
+    vec4 lightPos;
+    vec4 lightDirection;
+    vec4 lightColor;
+    int lightType;
+    float spotLightAngle;
+    bool enableAmbientLight;
+    bool enableDiffuseLight;
+    bool enableSpecularLight;
+};
 
 void main()
 {
@@ -1,12 +1,17 @@
 #version 330 core
 
-layout (location = 0) in vec3 lightPos;
+layout (location = 0) in vec3 position;
+
+layout (std140) uniform Frame
+{
+    mat4 view;
+    mat4 projection;
+    vec4 viewPos;
+};
 
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
 
 void main()
 {
-    gl_Position = projection * view * model * vec4(lightPos, 1.0f);
+    gl_Position = projection * view * model * vec4(position, 1.0f);
 }
@@ -0,0 +1,200 @@
+#include "include/benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+#include "include/glstate.h"
+#include "include/stats.h"
+
+Benchmark::Benchmark(GLint width, GLint height, GLuint frames, GpuTimer &timer)
+        : width(width), height(height), frames(frames), timer(timer)
+{
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+
+    glGenRenderbuffers(1, &colorBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+
+    glGenRenderbuffers(1, &depthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        std::cerr << "Benchmark framebuffer is incomplete!" << std::endl;
+
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    samples.resize(frames);
+    timer.record(true);
+    timer.takeCompleted();
+}
+
+Benchmark::~Benchmark()
+{
+    timer.record(false);
+
+    glDeleteRenderbuffers(1, &depthBuffer);
+    glDeleteRenderbuffers(1, &colorBuffer);
+    glDeleteFramebuffers(1, &framebuffer);
+}
+
+void Benchmark::beginFrame()
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    GLState::viewport(0, 0, width, height);
+
+    renderStats.reset();
+    frameStart = std::chrono::steady_clock::now();
+
+    if (currentFrame == 0) firstTimerFrame = timer.frameNumber();
+    timer.beginFrame();
+}
+
+void Benchmark::endFrame()
+{
+    timer.endFrame();
+    glFlush();
+
+    FrameSample &sample = samples[currentFrame];
+    sample.cpuTime = std::chrono::duration<GLdouble, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+    sample.drawCalls = renderStats.drawCalls;
+    sample.visibleObjects = renderStats.visibleObjects;
+    sample.culledObjects = renderStats.culledObjects;
+    sample.triangles = renderStats.triangles;
+
+    ++currentFrame;
+    collectGpuTimes();
+}
+
+bool Benchmark::finished() const { return currentFrame >= frames; }
+
+void Benchmark::collectGpuTimes()
+{
+    for (const auto &timings: timer.takeCompleted())
+    {
+        if (timings.frame < firstTimerFrame || timings.frame - firstTimerFrame >= currentFrame) continue;
+
+        FrameSample &sample = samples[timings.frame - firstTimerFrame];
+        sample.gpuTime = timings.total;
+        sample.passTimes = timings.passes;
+        sample.gpuTimed = true;
+    }
+}
+
+namespace
+{
+    std::string escape(const GLubyte* text)
+    {
+        std::string result;
+        for (const auto* c = reinterpret_cast<const GLchar*>(text); c && *c; ++c)
+        {
+            if (*c == '"' || *c == '\\') result += '\\';
+            result += *c;
+        }
+
+        return result;
+    }
+
+    template<typename Getter>
+    void writeSummary(std::ofstream &file, const std::vector<FrameSample> &samples, Getter getter)
+    {
+        if (samples.empty())
+        {
+            file << "null";
+            return;
+        }
+
+        std::vector<GLdouble> values;
+        values.reserve(samples.size());
+        for (const auto &sample: samples) values.push_back(static_cast<GLdouble>(getter(sample)));
+        std::sort(values.begin(), values.end());
+
+        auto percentile = [&](GLdouble p)
+        {
+            auto rank = static_cast<size_t>(std::ceil(p / 100.0 * static_cast<GLdouble>(values.size())));
+            return values[std::clamp<size_t>(rank, 1, values.size()) - 1];
+        };
+
+        GLdouble sum = 0.0;
+        for (GLdouble value: values) sum += value;
+
+        file << "{\"min\": " << values.front() << ", \"mean\": " << sum / static_cast<GLdouble>(values.size())
+             << ", \"p50\": " << percentile(50.0) << ", \"p95\": " << percentile(95.0) << ", \"p99\": "
+             << percentile(99.0) << ", \"max\": " << values.back() << "}";
+    }
+}
+
+void Benchmark::writeReport(const std::string &path)
+{
+    timer.flush();
+    collectGpuTimes();
+    samples.resize(currentFrame);
+
+    std::ofstream file(path);
+    if (!file.is_open() || samples.empty())
+    {
+        std::cerr << "Failed to write benchmark report to \"" << path << "\"" << std::endl;
+        return;
+    }
+
+    file << "{\n";
+    file << "  \"renderer\": \"" << escape(glGetString(GL_RENDERER)) << "\",\n";
+    file << "  \"version\": \"" << escape(glGetString(GL_VERSION)) << "\",\n";
+    file << "  \"width\": " << width << ",\n";
+    file << "  \"height\": " << height << ",\n";
+    file << "  \"frames\": " << samples.size() << ",\n";
+
+    // Frames whose timer queries were recycled before they resolved have no GPU time and are left out.
+    std::vector<FrameSample> timed;
+    std::ranges::copy_if(samples, std::back_inserter(timed), [](const FrameSample &sample) { return sample.gpuTimed; });
+    file << "  \"gpu_missing_frames\": " << samples.size() - timed.size() << ",\n";
+
+    file << "  \"cpu_ms\": ";
+    writeSummary(file, samples, [](const FrameSample &sample) { return sample.cpuTime; });
+    file << ",\n  \"gpu_ms\": ";
+    writeSummary(file, timed, [](const FrameSample &sample) { return sample.gpuTime; });
+    file << ",\n  \"gpu_pass_ms\": {";
+    for (GLuint pass = 0; pass < PASS_COUNT; ++pass)
+    {
+        file << (pass ? ", " : "") << "\"" << GPU_PASS_NAMES[pass] << "\": ";
+        writeSummary(file, timed, [pass](const FrameSample &sample) { return sample.passTimes[pass]; });
+    }
+    file << "}";
+    file << ",\n  \"draw_calls\": ";
+    writeSummary(file, samples, [](const FrameSample &sample) { return sample.drawCalls; });
+    file << ",\n  \"triangles\": ";
+    writeSummary(file, samples, [](const FrameSample &sample) { return sample.triangles; });
+    file << ",\n  \"visible_objects\": ";
+    writeSummary(file, samples, [](const FrameSample &sample) { return sample.visibleObjects; });
+    file << ",\n  \"culled_objects\": ";
+    writeSummary(file, samples, [](const FrameSample &sample) { return sample.culledObjects; });
+
+    file << ",\n  \"samples\": [\n";
+    for (size_t i = 0; i < samples.size(); ++i)
+    {
+        const FrameSample &sample = samples[i];
+        file << "    {\"cpu_ms\": " << sample.cpuTime << ", \"gpu_ms\": ";
+        if (sample.gpuTimed)
+        {
+            file << sample.gpuTime << ", \"gpu_pass_ms\": [";
+            for (GLuint pass = 0; pass < PASS_COUNT; ++pass) file << (pass ? ", " : "") << sample.passTimes[pass];
+            file << "]";
+        } else file << "null, \"gpu_pass_ms\": null";
+        file << ", \"draw_calls\": " << sample.drawCalls << ", \"triangles\": " << sample.triangles
+             << ", \"visible_objects\": " << sample.visibleObjects << ", \"culled_objects\": " << sample.culledObjects
+             << "}" << (i + 1 < samples.size() ? ",\n" : "\n");
+    }
+    file << "  ]\n}\n";
+
+    std::cout << "Wrote benchmark report for " << samples.size() << " frames to \"" << path << "\"" << std::endl;
+    if (timed.size() < samples.size())
+        std::cout << samples.size() - timed.size() << " frames had no GPU timings and were left out of gpu_ms"
+                  << std::endl;
+}
@@ -0,0 +1,304 @@
+#include "include/blockcompression.h"
+#include "include/profiler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BLOCKCOMPRESSION_SSE
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    constexpr GLint BLOCK_SIZE = 4, BLOCK_PIXELS = BLOCK_SIZE * BLOCK_SIZE;
+
+    std::vector<std::uint8_t> expandToRgba(const unsigned char* pixels, GLint width, GLint height, GLint numChannels)
+    {
+        std::vector<std::uint8_t> rgba(static_cast<size_t>(width) * height * 4);
+        for (size_t i = 0; i < static_cast<size_t>(width) * height; ++i)
+        {
+            const unsigned char* source = pixels + i * numChannels;
+            std::uint8_t* destination = rgba.data() + i * 4;
+
+            if (numChannels >= 3) std::memcpy(destination, source, 3);
+            else destination[0] = destination[1] = destination[2] = source[0];
+            destination[3] = numChannels == 4 ? source[3] : numChannels == 2 ? source[1] : 255;
+        }
+
+        return rgba;
+    }
+
+    std::vector<std::uint8_t> downsample(const std::vector<std::uint8_t> &source, GLint width, GLint height,
+                                         JobSystem* jobs)
+    {
+        GLint halfWidth = std::max(1, width / 2), halfHeight = std::max(1, height / 2);
+        std::vector<std::uint8_t> result(static_cast<size_t>(halfWidth) * halfHeight * 4);
+
+        auto filterRows = [&](size_t first, size_t last)
+        {
+            for (auto y = static_cast<GLint>(first); y < static_cast<GLint>(last); ++y)
+            {
+                GLint y0 = std::min(y * 2, height - 1), y1 = std::min(y * 2 + 1, height - 1);
+                for (GLint x = 0; x < halfWidth; ++x)
+                {
+                    GLint x0 = std::min(x * 2, width - 1), x1 = std::min(x * 2 + 1, width - 1);
+                    for (GLint channel = 0; channel < 4; ++channel)
+                    {
+                        GLuint sum = source[(y0 * width + x0) * 4 + channel] + source[(y0 * width + x1) * 4 + channel] +
+                                     source[(y1 * width + x0) * 4 + channel] + source[(y1 * width + x1) * 4 + channel];
+                        result[(y * halfWidth + x) * 4 + channel] = static_cast<std::uint8_t>((sum + 2) / 4);
+                    }
+                }
+            }
+        };
+
+        if (jobs) jobs->parallelFor(static_cast<size_t>(halfHeight), filterRows, 16);
+        else filterRows(0, halfHeight);
+
+        return result;
+    }
+
+    void fetchBlock(const std::uint8_t* rgba, GLint width, GLint height, GLint blockX, GLint blockY,
+                    std::uint8_t* block)
+    {
+        for (GLint y = 0; y < BLOCK_SIZE; ++y)
+        {
+            GLint sourceY = std::min(blockY * BLOCK_SIZE + y, height - 1);
+            const std::uint8_t* row = rgba + static_cast<size_t>(sourceY) * width * 4;
+
+            for (GLint x = 0; x < BLOCK_SIZE; ++x)
+            {
+                GLint sourceX = std::min(blockX * BLOCK_SIZE + x, width - 1);
+                std::memcpy(block + (y * BLOCK_SIZE + x) * 4, row + sourceX * 4, 4);
+            }
+        }
+    }
+
+    void blockRange(const std::uint8_t* block, std::uint8_t* minimum, std::uint8_t* maximum)
+    {
+        #if defined(BLOCKCOMPRESSION_SSE)
+        __m128i row0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block)),
+                row1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 16)),
+                row2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 32)),
+                row3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + 48));
+
+        __m128i low = _mm_min_epu8(_mm_min_epu8(row0, row1), _mm_min_epu8(row2, row3));
+        __m128i high = _mm_max_epu8(_mm_max_epu8(row0, row1), _mm_max_epu8(row2, row3));
+        low = _mm_min_epu8(low, _mm_srli_si128(low, 8));
+        high = _mm_max_epu8(high, _mm_srli_si128(high, 8));
+        low = _mm_min_epu8(low, _mm_srli_si128(low, 4));
+        high = _mm_max_epu8(high, _mm_srli_si128(high, 4));
+
+        GLint lowBits = _mm_cvtsi128_si32(low), highBits = _mm_cvtsi128_si32(high);
+        std::memcpy(minimum, &lowBits, 4);
+        std::memcpy(maximum, &highBits, 4);
+        #else
+        std::memcpy(minimum, block, 4);
+        std::memcpy(maximum, block, 4);
+        for (GLint i = 1; i < BLOCK_PIXELS; ++i)
+        {
+            for (GLint channel = 0; channel < 4; ++channel)
+            {
+                minimum[channel] = std::min(minimum[channel], block[i * 4 + channel]);
+                maximum[channel] = std::max(maximum[channel], block[i * 4 + channel]);
+            }
+        }
+        #endif
+    }
+
+    std::uint16_t pack565(const GLint* color)
+    {
+        return static_cast<std::uint16_t>((color[0] * 31 + 127) / 255 << 11 | (color[1] * 63 + 127) / 255 << 5 |
+                                          (color[2] * 31 + 127) / 255);
+    }
+
+    void unpack565(std::uint16_t packed, GLint* color)
+    {
+        GLint red = packed >> 11, green = packed >> 5 & 63, blue = packed & 31;
+        color[0] = red << 3 | red >> 2;
+        color[1] = green << 2 | green >> 4;
+        color[2] = blue << 3 | blue >> 2;
+    }
+
+    void encodeColorBlock(const std::uint8_t* block, const std::uint8_t* minimum, const std::uint8_t* maximum,
+                          std::byte* output)
+    {
+        GLint low[3], high[3], center[3];
+        for (GLint channel = 0; channel < 3; ++channel)
+        {
+            GLint inset = (maximum[channel] - minimum[channel]) >> 4;
+            low[channel] = minimum[channel] + inset;
+            high[channel] = maximum[channel] - inset;
+            center[channel] = (low[channel] + high[channel]) / 2;
+        }
+
+        // The bounding box spans the main diagonal; flip red and green against blue when the colors run the other way.
+        GLint redBlue = 0, greenBlue = 0;
+        for (GLint i = 0; i < BLOCK_PIXELS; ++i)
+        {
+            GLint blue = block[i * 4 + 2] - center[2];
+            redBlue += (block[i * 4] - center[0]) * blue;
+            greenBlue += (block[i * 4 + 1] - center[1]) * blue;
+        }
+        if (redBlue < 0) std::swap(low[0], high[0]);
+        if (greenBlue < 0) std::swap(low[1], high[1]);
+
+        std::uint16_t color0 = pack565(high), color1 = pack565(low);
+        if (color0 < color1) std::swap(color0, color1);
+
+        std::uint32_t indices = 0;
+        if (color0 != color1)
+        {
+            GLint palette[4][3];
+            unpack565(color0, palette[0]);
+            unpack565(color1, palette[1]);
+            for (GLint channel = 0; channel < 3; ++channel)
+            {
+                palette[2][channel] = (2 * palette[0][channel] + palette[1][channel]) / 3;
+                palette[3][channel] = (palette[0][channel] + 2 * palette[1][channel]) / 3;
+            }
+
+            for (GLint i = 0; i < BLOCK_PIXELS; ++i)
+            {
+                GLuint best = 0;
+                GLint bestDistance = std::numeric_limits<GLint>::max();
+                for (GLuint entry = 0; entry < 4; ++entry)
+                {
+                    GLint distance = 0;
+                    for (GLint channel = 0; channel < 3; ++channel)
+                    {
+                        GLint difference = block[i * 4 + channel] - palette[entry][channel];
+                        distance += difference * difference;
+                    }
+
+                    if (distance < bestDistance)
+                    {
+                        best = entry;
+                        bestDistance = distance;
+                    }
+                }
+
+                indices |= best << (2 * i);
+            }
+        }
+
+        std::memcpy(output, &color0, 2);
+        std::memcpy(output + 2, &color1, 2);
+        std::memcpy(output + 4, &indices, 4);
+    }
+
+    void encodeChannelBlock(const std::uint8_t* block, GLint channel, std::uint8_t minimum, std::uint8_t maximum,
+                            std::byte* output)
+    {
+        std::uint64_t indices = 0;
+        if (maximum > minimum)
+        {
+            GLint range = maximum - minimum;
+            for (GLint i = 0; i < BLOCK_PIXELS; ++i)
+            {
+                GLint position = ((maximum - block[i * 4 + channel]) * 7 + range / 2) / range;
+                std::uint64_t code = position == 0 ? 0 : position == 7 ? 1 : position + 1;
+                indices |= code << (3 * i);
+            }
+        }
+
+        output[0] = static_cast<std::byte>(maximum);
+        output[1] = static_cast<std::byte>(minimum);
+        std::memcpy(output + 2, &indices, 6);
+    }
+
+    void encodeBlock(const std::uint8_t* block, BlockFormat format, std::byte* output)
+    {
+        std::uint8_t minimum[4], maximum[4];
+        blockRange(block, minimum, maximum);
+
+        switch (format)
+        {
+            case BLOCK_BC1:
+                encodeColorBlock(block, minimum, maximum, output);
+                break;
+            case BLOCK_BC3:
+                encodeChannelBlock(block, 3, minimum[3], maximum[3], output);
+                encodeColorBlock(block, minimum, maximum, output + 8);
+                break;
+            case BLOCK_BC4:
+                encodeChannelBlock(block, 0, minimum[0], maximum[0], output);
+                break;
+            case BLOCK_BC5:
+                encodeChannelBlock(block, 0, minimum[0], maximum[0], output);
+                encodeChannelBlock(block, 1, minimum[1], maximum[1], output + 8);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+BlockFormat chooseBlockFormat(const std::string &path, const std::string &type, GLint numChannels)
+{
+    if (path.find("Normal") != std::string::npos || type == "normal") return BLOCK_BC5;
+    if (numChannels == 1 || type == "specular" || path.find("Roughness") != std::string::npos ||
+        path.find("AmbientOcclusion") != std::string::npos)
+        return BLOCK_BC4;
+
+    return numChannels == 2 || numChannels == 4 ? BLOCK_BC3 : BLOCK_BC1;
+}
+
+bool blockFormatSupported(BlockFormat format)
+{
+    return format == BLOCK_BC4 || format == BLOCK_BC5 || GLEW_EXT_texture_compression_s3tc;
+}
+
+CompressedImage compressImage(const unsigned char* pixels, GLint width, GLint height, GLint numChannels,
+                              BlockFormat format, JobSystem* jobs)
+{
+    PROFILE_SCOPE("compressImage");
+
+    CompressedImage image;
+    image.format = format;
+    if (!pixels || width <= 0 || height <= 0 || numChannels < 1 || numChannels > 4) return image;
+
+    size_t totalSize = 0;
+    for (GLint levelWidth = width, levelHeight = height;; levelWidth = std::max(1, levelWidth / 2),
+            levelHeight = std::max(1, levelHeight / 2))
+    {
+        size_t size = static_cast<size_t>((levelWidth + 3) / 4) * ((levelHeight + 3) / 4) * BLOCK_FORMAT_BYTES[format];
+        image.levels.push_back({levelWidth, levelHeight, totalSize, size});
+        totalSize += size;
+
+        if (levelWidth == 1 && levelHeight == 1) break;
+    }
+    image.data.resize(totalSize);
+
+    std::vector<std::uint8_t> rgba = expandToRgba(pixels, width, height, numChannels);
+    for (size_t level = 0; level < image.levels.size(); ++level)
+    {
+        const CompressedLevel &target = image.levels[level];
+        if (level > 0) rgba = downsample(rgba, image.levels[level - 1].width, image.levels[level - 1].height, jobs);
+
+        GLint blocksX = (target.width + 3) / 4, blocksY = (target.height + 3) / 4;
+        std::byte* output = image.data.data() + target.offset;
+
+        auto encodeRows = [&](size_t first, size_t last)
+        {
+            std::uint8_t block[BLOCK_PIXELS * 4];
+            for (auto blockY = static_cast<GLint>(first); blockY < static_cast<GLint>(last); ++blockY)
+            {
+                for (GLint blockX = 0; blockX < blocksX; ++blockX)
+                {
+                    fetchBlock(rgba.data(), target.width, target.height, blockX, blockY, block);
+                    encodeBlock(block, format, output + (static_cast<size_t>(blockY) * blocksX + blockX) *
+                                                        BLOCK_FORMAT_BYTES[format]);
+                }
+            }
+        };
+
+        if (jobs) jobs->parallelFor(static_cast<size_t>(blocksY), encodeRows, 4);
+        else encodeRows(0, blocksY);
+    }
+
+    return image;
+}
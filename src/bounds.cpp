@@ -0,0 +1,72 @@
+#include "include/bounds.h"
+
+AABB AABB::transformed(const glm::mat4 &matrix) const
+{
+    glm::vec3 localCenter = center(), localExtents = extents();
+    glm::vec3 worldCenter = glm::vec3(matrix * glm::vec4(localCenter, 1.0f)), worldExtents(0.0f);
+
+    for (GLint row = 0; row < 3; ++row)
+        for (GLint column = 0; column < 3; ++column)
+            worldExtents[row] += std::abs(matrix[column][row]) * localExtents[column];
+
+    return {worldCenter - worldExtents, worldCenter + worldExtents};
+}
+
+void AABB::expand(const AABB &other)
+{
+    for (GLint axis = 0; axis < 3; ++axis)
+    {
+        min[axis] = std::min(min[axis], other.min[axis]);
+        max[axis] = std::max(max[axis], other.max[axis]);
+    }
+}
+
+bool Ray::intersects(const AABB &box, const glm::vec3 &inverseDirection, GLfloat &distance) const
+{
+    GLfloat nearest = 0.0f, farthest = maxDistance;
+
+    for (GLint axis = 0; axis < 3; ++axis)
+    {
+        GLfloat t0 = (box.min[axis] - origin[axis]) * inverseDirection[axis];
+        GLfloat t1 = (box.max[axis] - origin[axis]) * inverseDirection[axis];
+        if (t0 > t1) std::swap(t0, t1);
+
+        nearest = std::max(nearest, t0);
+        farthest = std::min(farthest, t1);
+        if (nearest > farthest) return false;
+    }
+
+    distance = nearest;
+    return true;
+}
+
+BoundingSphere BoundingSphere::transformed(const glm::mat4 &matrix) const
+{
+    GLfloat scale = 0.0f;
+    for (GLint column = 0; column < 3; ++column) scale = std::max(scale, glm::length(glm::vec3(matrix[column])));
+
+    return {glm::vec3(matrix * glm::vec4(center, 1.0f)), radius * scale};
+}
+
+Bounds Bounds::fromPositions(const void* data, size_t count, size_t stride)
+{
+    if (count == 0) return {};
+
+    auto bytes = static_cast<const std::byte*>(data);
+    auto position = [&](size_t i) { return *reinterpret_cast<const glm::vec3*>(bytes + i * stride); };
+
+    Bounds bounds;
+    bounds.box = {position(0), position(0)};
+    for (size_t i = 1; i < count; ++i) bounds.box.expand({position(i), position(i)});
+
+    bounds.sphere.center = bounds.box.center();
+    for (size_t i = 0; i < count; ++i)
+        bounds.sphere.radius = std::max(bounds.sphere.radius, glm::length(position(i) - bounds.sphere.center));
+
+    return bounds;
+}
+
+Bounds Bounds::fromBox(const AABB &box)
+{
+    return {box, {box.center(), glm::length(box.extents())}};
+}
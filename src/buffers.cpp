@@ -0,0 +1,183 @@
+#include "include/buffers.h"
+#include "include/glstate.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+RingBuffer::RingBuffer(GLsizeiptr requestedSize)
+{
+    GLint alignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    if (alignment > 0) uniformAlignment = alignment;
+    if (GLEW_VERSION_4_3)
+    {
+        glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        if (alignment > 0) storageAlignment = alignment;
+    }
+
+    // Every frame region must start on a boundary that glBindBufferRange accepts for any target.
+    GLsizeiptr frameAlignment = std::max({uniformAlignment, storageAlignment, static_cast<GLsizeiptr>(16)});
+    frameSize = (requestedSize + frameAlignment - 1) / frameAlignment * frameAlignment;
+
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    glGenBuffers(1, &ID);
+    GLState::bindBuffer(GL_COPY_WRITE_BUFFER, ID);
+    glBufferStorage(GL_COPY_WRITE_BUFFER, frameSize * FRAMES, nullptr, flags);
+    mapping = static_cast<std::byte*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, frameSize * FRAMES, flags));
+
+    if (!mapping) std::cerr << "Failed to map ring buffer!" << std::endl;
+}
+
+RingBuffer::~RingBuffer()
+{
+    for (GLsync fence: fences) if (fence) glDeleteSync(fence);
+
+    if (mapping)
+    {
+        GLState::bindBuffer(GL_COPY_WRITE_BUFFER, ID);
+        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    }
+
+    GLState::forgetBuffer(ID);
+    glDeleteBuffers(1, &ID);
+}
+
+bool RingBuffer::supported() { return GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage; }
+
+void RingBuffer::beginFrame()
+{
+    waitTime = 0.0;
+    head.store(0, std::memory_order_relaxed);
+
+    GLsync &fence = fences[frame];
+    if (!fence) return;
+
+    if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        GLenum result;
+        do result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+        while (result == GL_TIMEOUT_EXPIRED);
+
+        waitTime = std::chrono::duration<GLdouble, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+void RingBuffer::endFrame()
+{
+    used = std::min(head.load(std::memory_order_relaxed), frameSize);
+    fences[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    frame = (frame + 1) % FRAMES;
+}
+
+RingBuffer::Allocation RingBuffer::allocate(GLenum target, GLsizeiptr size)
+{
+    if (!mapping) return {};
+
+    GLsizeiptr alignment = target == GL_UNIFORM_BUFFER ? uniformAlignment
+                           : target == GL_SHADER_STORAGE_BUFFER ? storageAlignment : 16;
+
+    GLsizeiptr offset = head.load(std::memory_order_relaxed), aligned;
+    do
+    {
+        aligned = (offset + alignment - 1) / alignment * alignment;
+        if (aligned + size > frameSize) return {};
+    } while (!head.compare_exchange_weak(offset, aligned + size, std::memory_order_relaxed));
+
+    GLintptr base = static_cast<GLintptr>(frame) * frameSize + aligned;
+    return {mapping + base, base, size};
+}
+
+void RingBuffer::bindRange(GLenum target, GLuint index, const Allocation &allocation) const
+{
+    GLState::bindBufferRange(target, index, ID, allocation.offset, allocation.size);
+}
+
+UniformBuffer::UniformBuffer(GLuint binding, GLsizeiptr size, RingBuffer* ring)
+        : binding(binding), size(size), ring(ring)
+{
+    glGenBuffers(1, &ID);
+    GLState::bindBufferBase(GL_UNIFORM_BUFFER, binding, ID);
+    glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+}
+
+UniformBuffer::~UniformBuffer()
+{
+    GLState::forgetBuffer(ID);
+    glDeleteBuffers(1, &ID);
+}
+
+void UniformBuffer::update(const void* data, GLsizeiptr dataSize) const
+{
+    if (ring)
+    {
+        RingBuffer::Allocation allocation = ring->allocate(GL_UNIFORM_BUFFER, dataSize);
+        if (allocation.valid())
+        {
+            std::memcpy(allocation.data, data, static_cast<size_t>(dataSize));
+            ring->bindRange(GL_UNIFORM_BUFFER, binding, allocation);
+            return;
+        }
+    }
+
+    GLState::bindBuffer(GL_UNIFORM_BUFFER, ID);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, dataSize, data);
+    GLState::bindBufferBase(GL_UNIFORM_BUFFER, binding, ID);
+}
+
+InstanceBuffer::InstanceBuffer() { glGenBuffers(1, &ID); }
+
+InstanceBuffer::~InstanceBuffer()
+{
+    GLState::forgetBuffer(ID);
+    glDeleteBuffers(1, &ID);
+}
+
+void InstanceBuffer::update(std::span<const glm::mat4> models)
+{
+    staging.resize(models.size());
+    for (size_t i = 0; i < models.size(); ++i)
+        staging[i] = {models[i], glm::transpose(glm::inverse(glm::mat3(models[i])))};
+
+    count = static_cast<GLsizei>(models.size());
+    auto dataSize = static_cast<GLsizeiptr>(staging.size() * sizeof(InstanceData));
+
+    GLState::bindBuffer(GL_ARRAY_BUFFER, ID);
+    if (dataSize > capacity)
+    {
+        capacity = dataSize;
+        glBufferData(GL_ARRAY_BUFFER, capacity, staging.data(), GL_DYNAMIC_DRAW);
+    } else
+    {
+        glBufferData(GL_ARRAY_BUFFER, capacity, nullptr, GL_DYNAMIC_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, dataSize, staging.data());
+    }
+}
+
+void InstanceBuffer::attach() const
+{
+    GLState::bindBuffer(GL_ARRAY_BUFFER, ID);
+
+    for (GLuint column = 0; column < 4; ++column)
+    {
+        GLuint location = INSTANCE_MODEL_LOCATION + column;
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+                              (void*) (offsetof(InstanceData, model) + column * sizeof(glm::vec4)));
+        glVertexAttribDivisor(location, 1);
+    }
+
+    for (GLuint column = 0; column < 3; ++column)
+    {
+        GLuint location = INSTANCE_NORMAL_LOCATION + column;
+        glVertexAttribPointer(location, 3, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+                              (void*) (offsetof(InstanceData, normal) + column * sizeof(glm::vec3)));
+        glVertexAttribDivisor(location, 1);
+    }
+}
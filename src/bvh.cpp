@@ -0,0 +1,429 @@
+#include "include/bvh.h"
+#include "include/profiler.h"
+
+#include <algorithm>
+#include <queue>
+
+namespace
+{
+    struct BuildContext
+    {
+        std::span<const AABB> boxes;
+        std::vector<glm::vec3> centroids;
+        std::atomic<GLuint> nodeCount = 1;
+    };
+
+    struct BuildTask
+    {
+        GLuint node, first, count;
+    };
+
+    struct Bin
+    {
+        AABB box;
+        GLuint count = 0;
+    };
+
+    void grow(AABB &box, const AABB &other, bool &empty)
+    {
+        if (empty) box = other;
+        else box.expand(other);
+
+        empty = false;
+    }
+
+    GLuint binOf(GLfloat centroid, GLfloat minimum, GLfloat scale)
+    {
+        return std::min(SceneBVH::BINS - 1, static_cast<GLuint>((centroid - minimum) * scale));
+    }
+
+    template<typename Nodes>
+    void buildNode(BuildContext &context, Nodes &nodes, std::vector<GLuint> &indices, std::vector<GLuint> &parents,
+                   BuildTask task, std::vector<BuildTask>* deferred, GLuint deferBelow)
+    {
+        auto &node = nodes[task.node];
+        node.first = task.first;
+        node.count = task.count;
+        node.left = 0;
+
+        bool empty = true;
+        AABB centroidBounds;
+        for (GLuint i = task.first; i < task.first + task.count; ++i)
+        {
+            grow(node.box, context.boxes[indices[i]], empty);
+            if (i == task.first) centroidBounds = {context.centroids[indices[i]], context.centroids[indices[i]]};
+            else centroidBounds.expand({context.centroids[indices[i]], context.centroids[indices[i]]});
+        }
+
+        if (task.count <= SceneBVH::MAX_LEAF_SIZE) return;
+
+        GLint bestAxis = -1;
+        GLuint bestSplit = 0;
+        GLfloat bestCost = std::numeric_limits<GLfloat>::max();
+        glm::vec3 extent = centroidBounds.max - centroidBounds.min;
+
+        for (GLint axis = 0; axis < 3; ++axis)
+        {
+            if (extent[axis] <= 0.0f) continue;
+
+            Bin bins[SceneBVH::BINS];
+            bool binEmpty[SceneBVH::BINS];
+            std::fill(std::begin(binEmpty), std::end(binEmpty), true);
+
+            GLfloat scale = static_cast<GLfloat>(SceneBVH::BINS) / extent[axis];
+            for (GLuint i = task.first; i < task.first + task.count; ++i)
+            {
+                GLuint id = indices[i];
+                GLuint bin = binOf(context.centroids[id][axis], centroidBounds.min[axis], scale);
+                grow(bins[bin].box, context.boxes[id], binEmpty[bin]);
+                ++bins[bin].count;
+            }
+
+            GLfloat leftArea[SceneBVH::BINS - 1];
+            GLuint leftCount[SceneBVH::BINS - 1];
+            AABB sweep;
+            bool sweepEmpty = true;
+            GLuint sweepCount = 0;
+
+            for (GLuint i = 0; i < SceneBVH::BINS - 1; ++i)
+            {
+                if (!binEmpty[i]) grow(sweep, bins[i].box, sweepEmpty);
+                sweepCount += bins[i].count;
+                leftArea[i] = sweepEmpty ? 0.0f : sweep.surfaceArea();
+                leftCount[i] = sweepCount;
+            }
+
+            sweepEmpty = true;
+            sweepCount = 0;
+            for (GLuint i = SceneBVH::BINS - 1; i > 0; --i)
+            {
+                if (!binEmpty[i]) grow(sweep, bins[i].box, sweepEmpty);
+                sweepCount += bins[i].count;
+
+                GLfloat splitCost = leftArea[i - 1] * static_cast<GLfloat>(leftCount[i - 1]) +
+                                    (sweepEmpty ? 0.0f : sweep.surfaceArea()) * static_cast<GLfloat>(sweepCount);
+                if (leftCount[i - 1] > 0 && sweepCount > 0 && splitCost < bestCost)
+                {
+                    bestCost = splitCost;
+                    bestAxis = axis;
+                    bestSplit = i;
+                }
+            }
+        }
+
+        GLfloat leafCost = node.box.surfaceArea() * static_cast<GLfloat>(task.count);
+        if (bestCost >= leafCost && task.count <= SceneBVH::MAX_LEAF_SIZE * 4) return;
+
+        auto begin = indices.begin() + task.first, end = begin + task.count, middle = begin + task.count / 2;
+        if (bestAxis >= 0)
+        {
+            GLfloat scale = static_cast<GLfloat>(SceneBVH::BINS) / extent[bestAxis];
+            middle = std::partition(begin, end, [&](GLuint id)
+            {
+                return binOf(context.centroids[id][bestAxis], centroidBounds.min[bestAxis], scale) < bestSplit;
+            });
+        }
+
+        if (middle == begin || middle == end) middle = begin + task.count / 2;
+
+        GLuint left = context.nodeCount.fetch_add(2);
+        node.left = left;
+        parents[left] = task.node;
+        parents[left + 1] = task.node;
+
+        auto leftCount = static_cast<GLuint>(middle - begin);
+        BuildTask children[] = {{left, task.first, leftCount}, {left + 1, task.first + leftCount,
+                                                                task.count - leftCount}};
+
+        for (const auto &child: children)
+        {
+            if (deferred && child.count <= deferBelow) deferred->push_back(child);
+            else buildNode(context, nodes, indices, parents, child, deferred, deferBelow);
+        }
+    }
+}
+
+SceneBVH::SceneBVH(JobSystem* jobs) : jobs(jobs) {}
+
+SceneBVH::~SceneBVH()
+{
+    if (pending) pending->done.wait(false);
+}
+
+void SceneBVH::build(std::span<const AABB> objectBoxes)
+{
+    PROFILE_SCOPE("SceneBVH::build");
+
+    if (pending)
+    {
+        pending->done.wait(false);
+        pending.reset();
+    }
+
+    boxes.assign(objectBoxes.begin(), objectBoxes.end());
+    tree = buildTree(boxes, jobs);
+
+    lastQuality = 1.0f;
+    updatesSinceCheck = 0;
+}
+
+SceneBVH::Tree SceneBVH::buildTree(std::span<const AABB> objectBoxes, JobSystem* jobs)
+{
+    Tree result;
+    auto count = static_cast<GLuint>(objectBoxes.size());
+    if (count == 0) return result;
+
+    BuildContext context;
+    context.boxes = objectBoxes;
+    context.centroids.resize(count);
+    for (GLuint i = 0; i < count; ++i) context.centroids[i] = objectBoxes[i].center();
+
+    result.nodes.resize(2 * count);
+    result.parents.assign(2 * count, 0);
+    result.indices.resize(count);
+    for (GLuint i = 0; i < count; ++i) result.indices[i] = i;
+
+    std::vector<BuildTask> deferred;
+    GLuint deferBelow = jobs ? std::max(1024u, count / static_cast<GLuint>(jobs->concurrency() * 8)) : 0;
+
+    buildNode(context, result.nodes, result.indices, result.parents, {0, 0, count}, jobs ? &deferred : nullptr,
+              deferBelow);
+
+    if (!deferred.empty())
+    {
+        JobCounter finished;
+        for (const auto &task: deferred)
+            jobs->submit([&, task]
+            {
+                buildNode(context, result.nodes, result.indices, result.parents, task, nullptr, 0);
+            }, &finished);
+
+        jobs->wait(finished);
+    }
+
+    result.nodes.resize(context.nodeCount.load());
+    result.parents.resize(result.nodes.size());
+    result.leafOf.resize(count);
+
+    for (GLuint i = 0; i < result.nodes.size(); ++i)
+    {
+        const Node &node = result.nodes[i];
+        if (!node.leaf()) continue;
+
+        for (GLuint j = node.first; j < node.first + node.count; ++j) result.leafOf[result.indices[j]] = i;
+    }
+
+    result.builtCost = treeCost(result);
+    return result;
+}
+
+void SceneBVH::update(GLuint id, const AABB &box)
+{
+    boxes[id] = box;
+    ++updatesSinceCheck;
+
+    GLuint node = tree.leafOf[id];
+    while (true)
+    {
+        refitNode(node);
+        if (node == 0) break;
+
+        node = tree.parents[node];
+    }
+}
+
+void SceneBVH::refit()
+{
+    PROFILE_SCOPE("SceneBVH::refit");
+
+    ++updatesSinceCheck;
+
+    for (auto node = static_cast<GLint>(tree.nodes.size()) - 1; node >= 0; --node)
+        refitNode(static_cast<GLuint>(node));
+}
+
+void SceneBVH::refitNode(GLuint index)
+{
+    Node &node = tree.nodes[index];
+
+    if (!node.leaf())
+    {
+        node.box = tree.nodes[node.left].box;
+        node.box.expand(tree.nodes[node.left + 1].box);
+        return;
+    }
+
+    node.box = boxes[tree.indices[node.first]];
+    for (GLuint i = node.first + 1; i < node.first + node.count; ++i) node.box.expand(boxes[tree.indices[i]]);
+}
+
+void SceneBVH::poll()
+{
+    if (pending)
+    {
+        if (!pending->done.load(std::memory_order_acquire)) return;
+
+        tree = std::move(pending->tree);
+        pending.reset();
+        ++rebuilds;
+
+        refit();
+        updatesSinceCheck = 0;
+        lastQuality = cost() / tree.builtCost;
+        return;
+    }
+
+    if (++framesSinceCheck < QUALITY_CHECK_INTERVAL || updatesSinceCheck == 0 || tree.nodes.empty()) return;
+
+    framesSinceCheck = 0;
+    updatesSinceCheck = 0;
+    lastQuality = cost() / tree.builtCost;
+
+    if (lastQuality < REBUILD_THRESHOLD || !jobs) return;
+
+    pending = std::make_shared<PendingBuild>();
+    pending->boxes = boxes;
+
+    jobs->submit([build = pending]()
+    {
+        PROFILE_SCOPE("SceneBVH::rebuild");
+
+        build->tree = buildTree(build->boxes, nullptr);
+        build->done.store(true, std::memory_order_release);
+        build->done.notify_all();
+    });
+}
+
+GLfloat SceneBVH::cost() const { return treeCost(tree); }
+
+GLfloat SceneBVH::treeCost(const Tree &bvh)
+{
+    if (bvh.nodes.empty()) return 0.0f;
+
+    GLfloat total = 0.0f;
+    for (const Node &node: bvh.nodes)
+        total += node.box.surfaceArea() * (node.leaf() ? static_cast<GLfloat>(node.count) : 1.0f);
+
+    GLfloat rootArea = bvh.nodes[0].box.surfaceArea();
+    return rootArea > 0.0f ? total / rootArea : total;
+}
+
+void SceneBVH::queryFrustum(const Frustum &frustum, std::vector<GLuint> &result) const
+{
+    PROFILE_SCOPE("SceneBVH::queryFrustum");
+
+    if (tree.nodes.empty()) return;
+
+    TraversalStack<MAX_DEPTH> stack;
+    stack.push(0);
+
+    while (!stack.empty())
+    {
+        const Node &node = tree.nodes[stack.pop()];
+
+        Containment containment = frustum.classify(node.box);
+        if (containment == OUTSIDE) continue;
+
+        if (containment == INSIDE || node.leaf())
+        {
+            for (GLuint i = node.first; i < node.first + node.count; ++i)
+            {
+                GLuint id = tree.indices[i];
+                if (containment == INSIDE || frustum.intersects(boxes[id])) result.push_back(id);
+            }
+
+            continue;
+        }
+
+        stack.push(node.left + 1);
+        stack.push(node.left);
+    }
+}
+
+void SceneBVH::queryRadius(const glm::vec3 &center, GLfloat radius, std::vector<GLuint> &result) const
+{
+    if (tree.nodes.empty()) return;
+
+    auto overlaps = [&](const AABB &box)
+    {
+        glm::vec3 closest = glm::clamp(center, box.min, box.max);
+        glm::vec3 offset = closest - center;
+        return glm::dot(offset, offset) <= radius * radius;
+    };
+
+    TraversalStack<MAX_DEPTH> stack;
+    stack.push(0);
+
+    while (!stack.empty())
+    {
+        const Node &node = tree.nodes[stack.pop()];
+        if (!overlaps(node.box)) continue;
+
+        if (node.leaf())
+        {
+            for (GLuint i = node.first; i < node.first + node.count; ++i)
+                if (overlaps(boxes[tree.indices[i]])) result.push_back(tree.indices[i]);
+
+            continue;
+        }
+
+        stack.push(node.left + 1);
+        stack.push(node.left);
+    }
+}
+
+GLuint SceneBVH::nearest(const glm::vec3 &point, GLfloat maxDistance) const
+{
+    if (tree.nodes.empty()) return INVALID_ID;
+
+    auto distanceSquared = [&](const AABB &box)
+    {
+        glm::vec3 offset = glm::clamp(point, box.min, box.max) - point;
+        return glm::dot(offset, offset);
+    };
+
+    using Entry = std::pair<GLfloat, GLuint>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<>> queue;
+    queue.emplace(distanceSquared(tree.nodes[0].box), 0);
+
+    GLuint best = INVALID_ID;
+    GLfloat bestDistance = maxDistance == std::numeric_limits<GLfloat>::max() ? maxDistance : maxDistance * maxDistance;
+
+    while (!queue.empty())
+    {
+        auto [distance, index] = queue.top();
+        queue.pop();
+        if (distance > bestDistance) break;
+
+        const Node &node = tree.nodes[index];
+        if (node.leaf())
+        {
+            for (GLuint i = node.first; i < node.first + node.count; ++i)
+            {
+                GLfloat candidate = distanceSquared(boxes[tree.indices[i]]);
+                if (candidate < bestDistance)
+                {
+                    bestDistance = candidate;
+                    best = tree.indices[i];
+                }
+            }
+
+            continue;
+        }
+
+        queue.emplace(distanceSquared(tree.nodes[node.left].box), node.left);
+        queue.emplace(distanceSquared(tree.nodes[node.left + 1].box), node.left + 1);
+    }
+
+    return best;
+}
+
+bool SceneBVH::raycast(const Ray &ray, RayHit &hit) const
+{
+    glm::vec3 inverseDirection = 1.0f / ray.direction;
+
+    return raycast(ray, hit, [&](GLuint id, const Ray &, GLfloat &distance)
+    {
+        return ray.intersects(boxes[id], inverseDirection, distance);
+    });
+}
@@ -17,6 +17,21 @@ glm::mat4 Camera::getProjectionMatrix(GLfloat aspectRatio, GLfloat fieldOfView)
     return glm::perspective(glm::radians(fieldOfView), aspectRatio, near, far);
 }
 
+Ray Camera::getScreenRay(GLfloat x, GLfloat y, GLfloat width, GLfloat height) const
+{
+    GLfloat tanHalfFov = std::tan(glm::radians(fov) / 2.0f);
+    GLfloat ndcX = 2.0f * x / width - 1.0f, ndcY = 1.0f - 2.0f * y / height;
+    glm::vec3 cameraUp = glm::cross(right, orientation);
+
+    Ray ray;
+    ray.origin = position;
+    ray.direction = glm::normalize(orientation + right * (ndcX * tanHalfFov * width / height) +
+                                   cameraUp * (ndcY * tanHalfFov));
+    ray.maxDistance = far;
+
+    return ray;
+}
+
 void Camera::processKeyboard(CameraMovement direction, GLdouble deltaTime)
 {
     auto velocity = static_cast<GLfloat>(movementSpeed * deltaTime);
@@ -0,0 +1,181 @@
+#include "include/culling.h"
+#include "include/profiler.h"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CULLING_SSE
+#include <emmintrin.h>
+#endif
+
+Frustum Frustum::fromMatrix(const glm::mat4 &viewProjection)
+{
+    auto row = [&](GLint i)
+    {
+        return glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+    };
+
+    Frustum frustum = {{row(3) + row(0), row(3) - row(0), row(3) + row(1), row(3) - row(1), row(3) + row(2),
+                        row(3) - row(2)}};
+    for (auto &plane: frustum.planes) plane /= glm::length(glm::vec3(plane));
+
+    return frustum;
+}
+
+Containment Frustum::classify(const AABB &box) const
+{
+    glm::vec3 center = box.center(), extents = box.extents();
+    Containment result = INSIDE;
+
+    for (const auto &plane: planes)
+    {
+        GLfloat distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+        GLfloat radius = std::abs(plane.x) * extents.x + std::abs(plane.y) * extents.y + std::abs(plane.z) * extents.z;
+
+        if (distance + radius < 0.0f) return OUTSIDE;
+        if (distance - radius < 0.0f) result = INTERSECTING;
+    }
+
+    return result;
+}
+
+bool Frustum::intersects(const AABB &box) const { return classify(box) != OUTSIDE; }
+
+bool Frustum::intersects(const BoundingSphere &sphere) const
+{
+    for (const auto &plane: planes)
+        if (glm::dot(glm::vec3(plane), sphere.center) + plane.w < -sphere.radius) return false;
+
+    return true;
+}
+
+void Culler::clear()
+{
+    count = 0;
+    visibleObjects = 0;
+    visibility.clear();
+}
+
+void Culler::reserve(size_t capacity)
+{
+    size_t padded = (capacity + LANES - 1) / LANES * LANES;
+    for (auto* array: {&centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ}) array->reserve(padded);
+    visibility.reserve(capacity);
+}
+
+GLuint Culler::add(const AABB &box)
+{
+    if (count == centerX.size())
+        for (auto* array: {&centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ})
+            array->resize(count + LANES, 0.0f);
+
+    visibility.push_back(1);
+    update(static_cast<GLuint>(count), box);
+
+    return static_cast<GLuint>(count++);
+}
+
+void Culler::update(GLuint index, const AABB &box)
+{
+    glm::vec3 center = box.center(), extents = box.extents();
+
+    centerX[index] = center.x;
+    centerY[index] = center.y;
+    centerZ[index] = center.z;
+    extentX[index] = extents.x;
+    extentY[index] = extents.y;
+    extentZ[index] = extents.z;
+}
+
+void Culler::cull(const Frustum &frustum, JobSystem* jobs)
+{
+    PROFILE_SCOPE("Culler::cull");
+
+    size_t groups = (count + LANES - 1) / LANES;
+    if (!jobs || groups < PARALLEL_GROUPS * 2)
+    {
+        visibleObjects = cullRange(frustum, 0, count);
+        return;
+    }
+
+    std::atomic<GLuint> visible = 0;
+    jobs->parallelFor(groups, [&](size_t first, size_t last)
+    {
+        visible.fetch_add(cullRange(frustum, first * LANES, std::min(last * LANES, count)), std::memory_order_relaxed);
+    }, PARALLEL_GROUPS);
+
+    visibleObjects = visible.load();
+}
+
+GLuint Culler::cullRange(const Frustum &frustum, size_t first, size_t last)
+{
+    size_t i = first;
+    GLuint visible = 0;
+
+    auto store = [&](size_t group, GLint mask, GLuint lanes)
+    {
+        for (GLuint lane = 0; lane < lanes && group + lane < last; ++lane)
+        {
+            visibility[group + lane] = static_cast<std::uint8_t>((mask >> lane) & 1);
+            visible += visibility[group + lane];
+        }
+    };
+
+    #if defined(__AVX__)
+    const __m256 zero = _mm256_setzero_ps(), signMask = _mm256_set1_ps(-0.0f);
+
+    for (; i < last; i += 8)
+    {
+        __m256 cx = _mm256_loadu_ps(&centerX[i]), cy = _mm256_loadu_ps(&centerY[i]), cz = _mm256_loadu_ps(&centerZ[i]);
+        __m256 ex = _mm256_loadu_ps(&extentX[i]), ey = _mm256_loadu_ps(&extentY[i]), ez = _mm256_loadu_ps(&extentZ[i]);
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+        for (const auto &plane: frustum.planes)
+        {
+            __m256 nx = _mm256_set1_ps(plane.x), ny = _mm256_set1_ps(plane.y), nz = _mm256_set1_ps(plane.z);
+
+            __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(cx, nx), _mm256_mul_ps(cy, ny)),
+                                            _mm256_add_ps(_mm256_mul_ps(cz, nz), _mm256_set1_ps(plane.w)));
+            __m256 radius = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ex, _mm256_andnot_ps(signMask, nx)),
+                                                        _mm256_mul_ps(ey, _mm256_andnot_ps(signMask, ny))),
+                                          _mm256_mul_ps(ez, _mm256_andnot_ps(signMask, nz)));
+
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(distance, radius), zero, _CMP_GE_OQ));
+        }
+
+        store(i, _mm256_movemask_ps(inside), 8);
+    }
+    #elif defined(CULLING_SSE)
+    const __m128 zero = _mm_setzero_ps(), signMask = _mm_set1_ps(-0.0f);
+
+    for (; i < last; i += 4)
+    {
+        __m128 cx = _mm_loadu_ps(&centerX[i]), cy = _mm_loadu_ps(&centerY[i]), cz = _mm_loadu_ps(&centerZ[i]);
+        __m128 ex = _mm_loadu_ps(&extentX[i]), ey = _mm_loadu_ps(&extentY[i]), ez = _mm_loadu_ps(&extentZ[i]);
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+        for (const auto &plane: frustum.planes)
+        {
+            __m128 nx = _mm_set1_ps(plane.x), ny = _mm_set1_ps(plane.y), nz = _mm_set1_ps(plane.z);
+
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, nx), _mm_mul_ps(cy, ny)),
+                                         _mm_add_ps(_mm_mul_ps(cz, nz), _mm_set1_ps(plane.w)));
+            __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ex, _mm_andnot_ps(signMask, nx)),
+                                                  _mm_mul_ps(ey, _mm_andnot_ps(signMask, ny))),
+                                       _mm_mul_ps(ez, _mm_andnot_ps(signMask, nz)));
+
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, radius), zero));
+        }
+
+        store(i, _mm_movemask_ps(inside), 4);
+    }
+    #endif
+
+    for (; i < last; ++i)
+    {
+        glm::vec3 center(centerX[i], centerY[i], centerZ[i]), extents(extentX[i], extentY[i], extentZ[i]);
+        store(i, frustum.intersects(AABB{center - extents, center + extents}) ? 1 : 0, 1);
+    }
+
+    return visible;
+}
@@ -0,0 +1,173 @@
+#include "include/ecs.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+
+std::array<ComponentType, ComponentRegistry::MAX_COMPONENTS> &ComponentRegistry::types()
+{
+    static std::array<ComponentType, MAX_COMPONENTS> registered;
+    return registered;
+}
+
+GLuint ComponentRegistry::add(const ComponentType &type)
+{
+    static std::mutex mutex;
+    static GLuint next = 0;
+    std::lock_guard lock(mutex);
+
+    if (next == MAX_COMPONENTS)
+    {
+        std::cerr << "Too many component types registered!" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    types()[next] = type;
+    return next++;
+}
+
+Archetype::Archetype(ComponentMask mask) : componentMask(mask)
+{
+    size_t entityBytes = sizeof(Entity);
+    for (GLuint id = 0; id < ComponentRegistry::MAX_COMPONENTS; ++id)
+    {
+        if (!(mask & ComponentMask(1) << id)) continue;
+
+        components.push_back(id);
+        entityBytes += ComponentRegistry::type(id).size;
+    }
+
+    auto layout = [&](GLuint rows)
+    {
+        size_t offset = sizeof(Entity) * rows;
+        for (GLuint id: components)
+        {
+            const ComponentType &type = ComponentRegistry::type(id);
+            offset = (offset + type.alignment - 1) / type.alignment * type.alignment;
+            offsets[id] = offset;
+            offset += type.size * rows;
+        }
+
+        return offset;
+    };
+
+    capacity = std::max<GLuint>(1, static_cast<GLuint>(CHUNK_BYTES / entityBytes));
+    while (capacity > 1 && layout(capacity) > CHUNK_BYTES) --capacity;
+    chunkBytes = layout(capacity);
+}
+
+Archetype::~Archetype()
+{
+    for (GLuint row = 0; row < count; ++row)
+        for (GLuint id: components) ComponentRegistry::type(id).destroy(component(id, row));
+}
+
+GLuint Archetype::allocate(Entity entity)
+{
+    if (count == chunks.size() * capacity)
+        chunks.emplace_back(static_cast<std::byte*>(::operator new[](chunkBytes, std::align_val_t(CHUNK_ALIGNMENT))));
+
+    GLuint row = count++;
+    new(&entityAt(row)) Entity(entity);
+
+    return row;
+}
+
+Entity Archetype::remove(GLuint row)
+{
+    GLuint last = --count;
+    Entity moved;
+
+    for (GLuint id: components)
+    {
+        const ComponentType &type = ComponentRegistry::type(id);
+        type.destroy(component(id, row));
+        if (row == last) continue;
+
+        type.move(component(id, row), component(id, last));
+        type.destroy(component(id, last));
+    }
+
+    if (row != last) moved = entityAt(row) = entityAt(last);
+    if (count <= (chunks.size() - 1) * capacity) chunks.pop_back();
+
+    return moved;
+}
+
+EntityWorld &EntityWorld::get()
+{
+    static EntityWorld world;
+    return world;
+}
+
+void EntityWorld::destroy(Entity entity)
+{
+    if (!alive(entity)) return;
+
+    release(entity);
+}
+
+Archetype &EntityWorld::archetype(ComponentMask mask)
+{
+    auto it = archetypeLookup.find(mask);
+    if (it != archetypeLookup.end()) return *it->second;
+
+    Archetype* created = archetypes.emplace_back(std::make_unique<Archetype>(mask)).get();
+    archetypeLookup.emplace(mask, created);
+
+    return *created;
+}
+
+Entity EntityWorld::allocate(Archetype &archetype)
+{
+    Entity entity;
+    if (freeIndices.empty())
+    {
+        entity.index = static_cast<GLuint>(records.size());
+        records.emplace_back();
+    } else
+    {
+        entity.index = freeIndices.back();
+        freeIndices.pop_back();
+    }
+
+    Record &record = records[entity.index];
+    entity.generation = record.generation;
+    record.archetype = &archetype;
+    record.row = archetype.allocate(entity);
+
+    return entity;
+}
+
+void EntityWorld::release(Entity entity)
+{
+    Record &record = records[entity.index];
+
+    Entity moved = record.archetype->remove(record.row);
+    if (moved.valid()) records[moved.index].row = record.row;
+
+    record.archetype = nullptr;
+    ++record.generation;
+    freeIndices.push_back(entity.index);
+}
+
+void EntityWorld::migrate(Entity entity, Archetype &target)
+{
+    Record &record = records[entity.index];
+    Archetype* source = record.archetype;
+    if (source == &target) return;
+
+    GLuint row = target.allocate(entity);
+    for (GLuint id: source->componentIds())
+    {
+        if (!(target.mask() & ComponentMask(1) << id)) continue;
+
+        ComponentRegistry::type(id).move(target.component(id, row), source->component(id, record.row));
+    }
+
+    Entity moved = source->remove(record.row);
+    if (moved.valid()) records[moved.index].row = record.row;
+
+    record.archetype = &target;
+    record.row = row;
+}
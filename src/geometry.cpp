@@ -0,0 +1,280 @@
+#include "include/geometry.h"
+#include "include/glstate.h"
+#include "include/profiler.h"
+
+#include <algorithm>
+#include <iostream>
+
+FreeListAllocator::FreeListAllocator(GLuint capacity) : total(capacity)
+{
+    if (capacity > 0) blocks.emplace(0, capacity);
+}
+
+std::optional<GLuint> FreeListAllocator::allocate(GLuint count)
+{
+    if (count == 0) return 0;
+
+    for (auto it = blocks.begin(); it != blocks.end(); ++it)
+    {
+        if (it->second < count) continue;
+
+        auto [offset, size] = *it;
+        blocks.erase(it);
+        if (size > count) blocks.emplace(offset + count, size - count);
+
+        allocated += count;
+        return offset;
+    }
+
+    return std::nullopt;
+}
+
+void FreeListAllocator::free(GLuint offset, GLuint count)
+{
+    if (count == 0) return;
+
+    allocated -= count;
+    insertBlock(offset, count);
+}
+
+void FreeListAllocator::grow(GLuint newCapacity)
+{
+    if (newCapacity <= total) return;
+
+    insertBlock(total, newCapacity - total);
+    total = newCapacity;
+}
+
+void FreeListAllocator::insertBlock(GLuint offset, GLuint count)
+{
+    auto next = blocks.lower_bound(offset);
+
+    if (next != blocks.begin())
+    {
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == offset)
+        {
+            offset = previous->first;
+            count += previous->second;
+            blocks.erase(previous);
+        }
+    }
+
+    if (next != blocks.end() && offset + count == next->first)
+    {
+        count += next->second;
+        blocks.erase(next);
+    }
+
+    blocks.emplace(offset, count);
+}
+
+Geometry::Geometry(GeometryPool &pool, GLint baseVertex, GLuint vertexCount, GLuint firstIndex, GLsizei count,
+                   GLenum mode)
+        : pool(pool), baseVertex(baseVertex), vertexCount(vertexCount), firstIndex(firstIndex), count(count),
+          mode(mode) {}
+
+Geometry::~Geometry() { pool.release(*this); }
+
+void Geometry::draw() const
+{
+    pool.bind();
+    glDrawElementsBaseVertex(mode, count, GL_UNSIGNED_INT, (void*) (firstIndex * sizeof(GLuint)), baseVertex);
+    renderStats.recordDraw(mode, count);
+}
+
+void Geometry::drawInstanced(const InstanceBuffer &instances) const
+{
+    if (instances.size() == 0) return;
+
+    pool.bind(INSTANCE_ARRAYS_TRANSFORM);
+    instances.attach();
+    glDrawElementsInstancedBaseVertex(mode, count, GL_UNSIGNED_INT, (void*) (firstIndex * sizeof(GLuint)),
+                                      instances.size(), baseVertex);
+    renderStats.recordDraw(mode, count, instances.size());
+}
+
+GeometryPool::GeometryPool(VertexFormat format)
+        : format(format), vertexAllocator(INITIAL_VERTICES), indexAllocator(INITIAL_INDICES)
+{
+    glGenVertexArrays(1, &VAO);
+    glGenBuffers(1, &VBO);
+    glGenBuffers(1, &EBO);
+
+    GLState::bindBuffer(GL_COPY_WRITE_BUFFER, VBO);
+    glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(INITIAL_VERTICES) * VERTEX_FORMAT_STRIDES[format],
+                 nullptr, GL_STATIC_DRAW);
+    GLState::bindBuffer(GL_COPY_WRITE_BUFFER, EBO);
+    glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(INITIAL_INDICES * sizeof(GLuint)), nullptr,
+                 GL_STATIC_DRAW);
+
+    setupAttributes();
+}
+
+GeometryPool::~GeometryPool()
+{
+    GLState::forgetVertexArray(VAO);
+    GLState::forgetBuffer(VBO);
+    GLState::forgetBuffer(EBO);
+
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &VBO);
+    glDeleteBuffers(1, &EBO);
+}
+
+std::shared_ptr<Geometry> GeometryPool::allocate(const void* vertexData, GLuint vertexCount,
+                                                 std::span<const GLuint> indexData, GLenum mode)
+{
+    PROFILE_SCOPE("GeometryPool::allocate");
+
+    GLsizeiptr stride = VERTEX_FORMAT_STRIDES[format];
+    auto indexCount = static_cast<GLuint>(indexData.size());
+
+    auto baseVertex = vertexAllocator.allocate(vertexCount);
+    if (!baseVertex)
+    {
+        growAllocator(vertexAllocator, VBO, stride, vertexCount);
+        baseVertex = vertexAllocator.allocate(vertexCount);
+        setupAttributes();
+    }
+
+    auto firstIndex = indexAllocator.allocate(indexCount);
+    if (!firstIndex)
+    {
+        growAllocator(indexAllocator, EBO, sizeof(GLuint), indexCount);
+        firstIndex = indexAllocator.allocate(indexCount);
+        setupAttributes();
+    }
+
+    if (!baseVertex || !firstIndex)
+    {
+        if (baseVertex) vertexAllocator.free(*baseVertex, vertexCount);
+        if (firstIndex) indexAllocator.free(*firstIndex, indexCount);
+
+        std::cerr << "Failed to allocate " << vertexCount << " vertices and " << indexCount
+                  << " indices from the geometry pool" << std::endl;
+        return nullptr;
+    }
+
+    GLState::bindBuffer(GL_COPY_WRITE_BUFFER, VBO);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, *baseVertex * stride, vertexCount * stride, vertexData);
+    GLState::bindBuffer(GL_COPY_WRITE_BUFFER, EBO);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(*firstIndex * sizeof(GLuint)),
+                    static_cast<GLsizeiptr>(indexData.size_bytes()), indexData.data());
+
+    auto geometry = std::make_shared<Geometry>(*this, static_cast<GLint>(*baseVertex), vertexCount, *firstIndex,
+                                               static_cast<GLsizei>(indexCount), mode);
+    geometry->bounds = Bounds::fromPositions(vertexData, vertexCount, static_cast<size_t>(stride));
+
+    return geometry;
+}
+
+void GeometryPool::reserve(GLuint vertexCount, GLuint indexCount)
+{
+    PROFILE_SCOPE("GeometryPool::reserve");
+
+    bool grown = false;
+    if (vertexAllocator.capacity() - vertexAllocator.used() < vertexCount)
+    {
+        growAllocator(vertexAllocator, VBO, VERTEX_FORMAT_STRIDES[format], vertexCount);
+        grown = true;
+    }
+
+    if (indexAllocator.capacity() - indexAllocator.used() < indexCount)
+    {
+        growAllocator(indexAllocator, EBO, sizeof(GLuint), indexCount);
+        grown = true;
+    }
+
+    if (grown) setupAttributes();
+}
+
+void GeometryPool::release(const Geometry &geometry)
+{
+    vertexAllocator.free(static_cast<GLuint>(geometry.baseVertex), geometry.vertexCount);
+    indexAllocator.free(geometry.firstIndex, static_cast<GLuint>(geometry.count));
+}
+
+void GeometryPool::bind(GLuint instanceArrays) const
+{
+    GLState::bindVertexArray(VAO);
+    if (instanceArrays == enabledArrays) return;
+
+    // Per-instance arrays left enabled for another draw path would be fetched past the end of their buffers.
+    auto toggle = [&](GLuint arrays, GLuint first, GLuint count)
+    {
+        if (((instanceArrays ^ enabledArrays) & arrays) == 0) return;
+        for (GLuint location = first; location < first + count; ++location)
+        {
+            if (instanceArrays & arrays) glEnableVertexAttribArray(location);
+            else glDisableVertexAttribArray(location);
+        }
+    };
+
+    toggle(INSTANCE_ARRAYS_TRANSFORM, INSTANCE_MODEL_LOCATION, INSTANCE_NORMAL_LOCATION + 3 - INSTANCE_MODEL_LOCATION);
+    toggle(INSTANCE_ARRAYS_DRAW_ID, DRAW_ID_LOCATION, 1);
+    toggle(INSTANCE_ARRAYS_CULLED, CULLED_INSTANCE_LOCATION, 1);
+    enabledArrays = instanceArrays;
+}
+
+GeometryPool &GeometryPool::get(VertexFormat format)
+{
+    if (!pools[format]) pools[format] = std::make_unique<GeometryPool>(format);
+    return *pools[format];
+}
+
+void GeometryPool::releaseAll()
+{
+    GLState::bindVertexArray(0);
+    for (auto &pool: pools) pool.reset();
+}
+
+void GeometryPool::setupAttributes() const
+{
+    GLState::bindVertexArray(VAO);
+    GLState::bindBuffer(GL_ARRAY_BUFFER, VBO);
+    GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+
+    if (format == VERTEX_FORMAT_POSITION)
+    {
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), nullptr);
+        glEnableVertexAttribArray(0);
+    } else
+    {
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*) offsetof(Vertex, position));
+        glEnableVertexAttribArray(0);
+
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*) offsetof(Vertex, normal));
+        glEnableVertexAttribArray(1);
+
+        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*) offsetof(Vertex, color));
+        glEnableVertexAttribArray(2);
+
+        glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*) offsetof(Vertex, texCoords));
+        glEnableVertexAttribArray(3);
+    }
+}
+
+void GeometryPool::growAllocator(FreeListAllocator &allocator, GLuint &buffer, GLsizeiptr elementSize, GLuint count)
+{
+    GLuint capacity = std::max(allocator.capacity() * 2, allocator.capacity() + count);
+    growBuffer(buffer, allocator.capacity() * elementSize, capacity * elementSize);
+    allocator.grow(capacity);
+}
+
+void GeometryPool::growBuffer(GLuint &buffer, GLsizeiptr oldSize, GLsizeiptr newSize)
+{
+    PROFILE_SCOPE("GeometryPool::growBuffer");
+
+    GLuint grown = 0;
+    glGenBuffers(1, &grown);
+
+    GLState::bindBuffer(GL_COPY_WRITE_BUFFER, grown);
+    glBufferData(GL_COPY_WRITE_BUFFER, newSize, nullptr, GL_STATIC_DRAW);
+    GLState::bindBuffer(GL_COPY_READ_BUFFER, buffer);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldSize);
+
+    GLState::forgetBuffer(buffer);
+    glDeleteBuffers(1, &buffer);
+    buffer = grown;
+}
@@ -0,0 +1,239 @@
+#include "include/glstate.h"
+
+#include <numeric>
+
+GLuint GLStateCounters::totalIssued() const { return std::accumulate(issued.begin(), issued.end(), 0u); }
+
+GLuint GLStateCounters::totalElided() const { return std::accumulate(elided.begin(), elided.end(), 0u); }
+
+void GLState::useProgram(GLuint id)
+{
+    if (track(CALL_PROGRAM, program, id)) glUseProgram(id);
+}
+
+void GLState::bindVertexArray(GLuint id)
+{
+    if (!track(CALL_VERTEX_ARRAY, vertexArray, id)) return;
+
+    glBindVertexArray(id);
+    buffers[TARGET_ELEMENT_ARRAY] = UNKNOWN;
+}
+
+void GLState::bindBuffer(GLenum target, GLuint buffer)
+{
+    GLint index = bufferTarget(target);
+    if (index < 0)
+    {
+        glBindBuffer(target, buffer);
+        ++current.issued[CALL_BUFFER];
+    } else if (track(CALL_BUFFER, buffers[index], buffer)) glBindBuffer(target, buffer);
+}
+
+void GLState::bindBufferBase(GLenum target, GLuint index, GLuint buffer)
+{
+    GLint slot = bufferTarget(target);
+    if (slot < 0 || index >= BUFFER_BINDINGS || track(CALL_BUFFER_BASE, bufferBases[slot][index], buffer))
+    {
+        glBindBufferBase(target, index, buffer);
+        if (slot >= 0) buffers[slot] = buffer;
+    }
+}
+
+void GLState::bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+{
+    glBindBufferRange(target, index, buffer, offset, size);
+    ++current.issued[CALL_BUFFER_BASE];
+
+    GLint slot = bufferTarget(target);
+    if (slot < 0) return;
+
+    buffers[slot] = buffer;
+    if (index < BUFFER_BINDINGS) bufferBases[slot][index] = UNKNOWN;
+}
+
+void GLState::bindTexture(GLuint unit, GLenum target, GLuint texture)
+{
+    // The active unit is switched even when the binding is cached, since callers edit the texture they just bound.
+    if (track(CALL_ACTIVE_TEXTURE, activeUnit, unit)) glActiveTexture(GL_TEXTURE0 + unit);
+
+    GLint slot = textureTarget(target);
+    if (unit < TEXTURE_UNITS && slot >= 0 && textures[unit][slot] == texture)
+    {
+        ++current.elided[CALL_TEXTURE];
+        return;
+    }
+
+    glBindTexture(target, texture);
+    ++current.issued[CALL_TEXTURE];
+
+    if (unit < TEXTURE_UNITS && slot >= 0) textures[unit][slot] = texture;
+}
+
+void GLState::bindSampler(GLuint unit, GLuint sampler)
+{
+    if (unit >= TEXTURE_UNITS || track(CALL_SAMPLER, samplers[unit], sampler)) glBindSampler(unit, sampler);
+}
+
+void GLState::setEnabled(GLenum capability, bool enabled)
+{
+    GLint index = capabilityIndex(capability);
+    if (index >= 0 && !track(CALL_CAPABILITY, capabilities[index], enabled)) return;
+
+    if (enabled) glEnable(capability);
+    else glDisable(capability);
+    if (index < 0) ++current.issued[CALL_CAPABILITY];
+}
+
+void GLState::blendFunc(GLenum source, GLenum destination)
+{
+    if (blend[0] == source && blend[1] == destination)
+    {
+        ++current.elided[CALL_BLEND];
+        return;
+    }
+
+    glBlendFunc(source, destination);
+    blend = {source, destination};
+    ++current.issued[CALL_BLEND];
+}
+
+void GLState::depthFunc(GLenum function)
+{
+    if (track(CALL_DEPTH, depthFunction, function)) glDepthFunc(function);
+}
+
+void GLState::depthMask(bool enabled)
+{
+    if (track(CALL_DEPTH, depthWrite, enabled)) glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+}
+
+void GLState::viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+    std::array<GLint, 4> rect = {x, y, width, height};
+    if (viewportKnown && viewportRect == rect)
+    {
+        ++current.elided[CALL_VIEWPORT];
+        return;
+    }
+
+    glViewport(x, y, width, height);
+    viewportRect = rect;
+    viewportKnown = true;
+    ++current.issued[CALL_VIEWPORT];
+}
+
+void GLState::forgetProgram(GLuint id)
+{
+    if (program == id) program = UNKNOWN;
+}
+
+void GLState::forgetVertexArray(GLuint id)
+{
+    if (vertexArray == id) vertexArray = UNKNOWN;
+}
+
+void GLState::forgetBuffer(GLuint buffer)
+{
+    for (auto &bound: buffers)
+        if (bound == buffer) bound = UNKNOWN;
+    for (auto &bases: bufferBases)
+        for (auto &bound: bases)
+            if (bound == buffer) bound = UNKNOWN;
+}
+
+void GLState::forgetTexture(GLuint texture)
+{
+    for (auto &unit: textures)
+        for (auto &bound: unit)
+            if (bound == texture) bound = UNKNOWN;
+}
+
+void GLState::invalidate()
+{
+    program = vertexArray = activeUnit = depthFunction = depthWrite = UNKNOWN;
+    buffers.fill(UNKNOWN);
+    for (auto &bases: bufferBases) bases.fill(UNKNOWN);
+    for (auto &unit: textures) unit.fill(UNKNOWN);
+    samplers.fill(UNKNOWN);
+    capabilities.fill(UNKNOWN);
+    blend.fill(UNKNOWN);
+    viewportKnown = false;
+}
+
+void GLState::beginFrame()
+{
+    previous = current;
+    current = {};
+}
+
+bool GLState::track(GLStateCall call, GLuint &cached, GLuint value)
+{
+    if (cached == value)
+    {
+        ++current.elided[call];
+        return false;
+    }
+
+    cached = value;
+    ++current.issued[call];
+    return true;
+}
+
+GLint GLState::bufferTarget(GLenum target)
+{
+    switch (target)
+    {
+        case GL_ARRAY_BUFFER:
+            return TARGET_ARRAY;
+        case GL_ELEMENT_ARRAY_BUFFER:
+            return TARGET_ELEMENT_ARRAY;
+        case GL_UNIFORM_BUFFER:
+            return TARGET_UNIFORM;
+        case GL_COPY_READ_BUFFER:
+            return TARGET_COPY_READ;
+        case GL_COPY_WRITE_BUFFER:
+            return TARGET_COPY_WRITE;
+        case GL_PIXEL_UNPACK_BUFFER:
+            return TARGET_PIXEL_UNPACK;
+        case GL_DRAW_INDIRECT_BUFFER:
+            return TARGET_DRAW_INDIRECT;
+        case GL_SHADER_STORAGE_BUFFER:
+            return TARGET_SHADER_STORAGE;
+        case GL_DISPATCH_INDIRECT_BUFFER:
+            return TARGET_DISPATCH_INDIRECT;
+        default:
+            return -1;
+    }
+}
+
+GLint GLState::textureTarget(GLenum target)
+{
+    switch (target)
+    {
+        case GL_TEXTURE_2D:
+            return TEXTURE_2D;
+        case GL_TEXTURE_2D_ARRAY:
+            return TEXTURE_2D_ARRAY;
+        case GL_TEXTURE_CUBE_MAP:
+            return TEXTURE_CUBE_MAP;
+        default:
+            return -1;
+    }
+}
+
+GLint GLState::capabilityIndex(GLenum capability)
+{
+    switch (capability)
+    {
+        case GL_DEPTH_TEST:
+            return CAPABILITY_DEPTH_TEST;
+        case GL_BLEND:
+            return CAPABILITY_BLEND;
+        case GL_CULL_FACE:
+            return CAPABILITY_CULL_FACE;
+        case GL_SCISSOR_TEST:
+            return CAPABILITY_SCISSOR_TEST;
+        default:
+            return -1;
+    }
+}
@@ -0,0 +1,236 @@
+#include "include/gpuculling.h"
+#include "include/glstate.h"
+#include "include/profiler.h"
+#include "include/stats.h"
+
+#include <algorithm>
+#include <bit>
+
+DepthPyramid::~DepthPyramid()
+{
+    GLState::forgetTexture(texture);
+    GLState::forgetTexture(depthCopy);
+
+    glDeleteTextures(1, &texture);
+    glDeleteTextures(1, &depthCopy);
+}
+
+void DepthPyramid::build(const Shader &reduce, GLsizei newWidth, GLsizei newHeight)
+{
+    PROFILE_SCOPE("DepthPyramid::build");
+
+    if (newWidth <= 0 || newHeight <= 0) return;
+    if (newWidth != width || newHeight != height) resize(newWidth, newHeight);
+
+    GLState::bindTexture(0, GL_TEXTURE_2D, depthCopy);
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, width, height);
+
+    reduce.use();
+    auto sourceLevel = reduce.getUniform<GLint>("sourceLevel");
+    auto scale = reduce.getUniform<GLint>("scale");
+
+    for (GLint level = 0; level < levels; ++level)
+    {
+        GLsizei levelWidth = std::max(1, width >> level), levelHeight = std::max(1, height >> level);
+
+        GLState::bindTexture(0, GL_TEXTURE_2D, level == 0 ? depthCopy : texture);
+        reduce.set(sourceLevel, std::max(level - 1, 0));
+        reduce.set(scale, level == 0 ? 1 : 2);
+        glBindImageTexture(0, texture, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+
+        glDispatchCompute((levelWidth + GpuCuller::PYRAMID_GROUP_SIZE - 1) / GpuCuller::PYRAMID_GROUP_SIZE,
+                          (levelHeight + GpuCuller::PYRAMID_GROUP_SIZE - 1) / GpuCuller::PYRAMID_GROUP_SIZE, 1);
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+    }
+}
+
+void DepthPyramid::resize(GLsizei newWidth, GLsizei newHeight)
+{
+    GLState::forgetTexture(texture);
+    GLState::forgetTexture(depthCopy);
+    glDeleteTextures(1, &texture);
+    glDeleteTextures(1, &depthCopy);
+
+    width = newWidth;
+    height = newHeight;
+    levels = std::bit_width(static_cast<GLuint>(std::max(width, height)));
+
+    glGenTextures(1, &depthCopy);
+    GLState::bindTexture(0, GL_TEXTURE_2D, depthCopy);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT32F, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    glGenTextures(1, &texture);
+    GLState::bindTexture(0, GL_TEXTURE_2D, texture);
+    glTexStorage2D(GL_TEXTURE_2D, levels, GL_R32F, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+}
+
+GpuCuller::GpuCuller(std::shared_ptr<Shader> cullShader, std::shared_ptr<Shader> reduceShader,
+                     std::shared_ptr<Shader> drawShader)
+        : drawShader(std::move(drawShader)), cullShader(std::move(cullShader)), reduceShader(std::move(reduceShader))
+{
+    instanceCountUniform = this->cullShader->getUniform<GLuint>("instanceCount");
+    planesUniform = this->cullShader->getUniform<glm::vec4>("planes");
+    occlusionUniform = this->cullShader->getUniform<bool>("occlusion");
+    pyramidViewProjectionUniform = this->cullShader->getUniform<glm::mat4>("pyramidViewProjection");
+
+    glGenBuffers(1, &instanceBuffer);
+    glGenBuffers(1, &commandBuffer);
+    glGenBuffers(1, &visibleBuffer);
+}
+
+GpuCuller::~GpuCuller()
+{
+    for (GLuint buffer: {instanceBuffer, commandBuffer, visibleBuffer}) GLState::forgetBuffer(buffer);
+
+    glDeleteBuffers(1, &instanceBuffer);
+    glDeleteBuffers(1, &commandBuffer);
+    glDeleteBuffers(1, &visibleBuffer);
+}
+
+bool GpuCuller::supported() { return GLEW_VERSION_4_3; }
+
+GLuint GpuCuller::add(const Geometry &geometry, const glm::mat4 &model, const AABB &localBox)
+{
+    if (!geometries.empty() && &geometries.front()->pool != &geometry.pool)
+    {
+        std::cerr << "Ignoring GPU culled instance from a different geometry pool" << std::endl;
+        return INVALID_INDEX;
+    }
+
+    auto command = std::ranges::find(geometries, &geometry);
+    if (command == geometries.end()) command = geometries.insert(geometries.end(), &geometry);
+
+    auto index = static_cast<GLuint>(instances.size());
+    instances.push_back({.model = {}, .normal = {}, .center = glm::vec4(localBox.center(), 1.0f),
+                         .extents = localBox.extents(),
+                         .command = static_cast<GLuint>(command - geometries.begin())});
+    update(index, model);
+
+    layoutDirty = true;
+    return index;
+}
+
+void GpuCuller::update(GLuint index, const glm::mat4 &model)
+{
+    glm::mat3 normal = glm::transpose(glm::inverse(glm::mat3(model)));
+
+    CullInstance &instance = instances[index];
+    instance.model = model;
+    instance.normal[0] = glm::vec4(normal[0], 0.0f);
+    instance.normal[1] = glm::vec4(normal[1], 0.0f);
+    instance.normal[2] = glm::vec4(normal[2], 0.0f);
+
+    markDirty(index);
+}
+
+void GpuCuller::cull(const Frustum &frustum, bool occlusion)
+{
+    PROFILE_SCOPE("GpuCuller::cull");
+
+    if (instances.empty()) return;
+
+    if (layoutDirty) rebuildCommands();
+
+    GLuint first = dirtyFirst.exchange(INVALID_INDEX, std::memory_order_relaxed);
+    GLuint last = dirtyLast.exchange(0, std::memory_order_relaxed);
+    if (first < last)
+    {
+        GLState::bindBuffer(GL_SHADER_STORAGE_BUFFER, instanceBuffer);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, static_cast<GLintptr>(first * sizeof(CullInstance)),
+                        static_cast<GLsizeiptr>((last - first) * sizeof(CullInstance)), instances.data() + first);
+    }
+
+    GLState::bindBuffer(GL_SHADER_STORAGE_BUFFER, commandBuffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0,
+                    static_cast<GLsizeiptr>(commands.size() * sizeof(DrawElementsIndirectCommand)), commands.data());
+
+    GLState::bindBufferBase(GL_SHADER_STORAGE_BUFFER, CULL_INSTANCE_STORAGE_BINDING, instanceBuffer);
+    GLState::bindBufferBase(GL_SHADER_STORAGE_BUFFER, CULL_COMMAND_STORAGE_BINDING, commandBuffer);
+    GLState::bindBufferBase(GL_SHADER_STORAGE_BUFFER, CULL_VISIBLE_STORAGE_BINDING, visibleBuffer);
+
+    cullShader->use();
+    cullShader->set(instanceCountUniform, static_cast<GLuint>(instances.size()));
+    cullShader->set(planesUniform, frustum.planes);
+    cullShader->set(occlusionUniform, occlusion && pyramid.valid());
+    cullShader->set(pyramidViewProjectionUniform, pyramidViewProjection);
+    if (pyramid.valid()) GLState::bindTexture(0, GL_TEXTURE_2D, pyramid.texture);
+
+    glDispatchCompute((static_cast<GLuint>(instances.size()) + GROUP_SIZE - 1) / GROUP_SIZE, 1, 1);
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+}
+
+void GpuCuller::draw()
+{
+    PROFILE_SCOPE("GpuCuller::draw");
+
+    if (instances.empty()) return;
+
+    const Geometry &first = *geometries.front();
+
+    drawShader->use();
+    first.pool.bind(INSTANCE_ARRAYS_CULLED);
+    GLState::bindBufferBase(GL_SHADER_STORAGE_BUFFER, CULL_INSTANCE_STORAGE_BINDING, instanceBuffer);
+    GLState::bindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+
+    glMultiDrawElementsIndirect(first.mode, GL_UNSIGNED_INT, nullptr, static_cast<GLsizei>(commands.size()), 0);
+
+    // The visible counts never leave the GPU, so this records every submitted instance as an upper bound.
+    ++renderStats.drawCalls;
+    for (size_t i = 0; i < commands.size(); ++i)
+        renderStats.recordTriangles(first.mode, static_cast<GLsizei>(commands[i].count),
+                                    static_cast<GLsizei>(capacities[i]));
+}
+
+void GpuCuller::buildPyramid(const glm::mat4 &viewProjection, GLsizei width, GLsizei height)
+{
+    pyramid.build(*reduceShader, width, height);
+    pyramidViewProjection = viewProjection;
+}
+
+void GpuCuller::markDirty(GLuint index)
+{
+    GLuint first = dirtyFirst.load(std::memory_order_relaxed);
+    while (index < first && !dirtyFirst.compare_exchange_weak(first, index, std::memory_order_relaxed));
+
+    GLuint last = dirtyLast.load(std::memory_order_relaxed);
+    while (index + 1 > last && !dirtyLast.compare_exchange_weak(last, index + 1, std::memory_order_relaxed));
+}
+
+void GpuCuller::rebuildCommands()
+{
+    capacities.assign(geometries.size(), 0);
+    for (const auto &instance: instances) ++capacities[instance.command];
+
+    commands.resize(geometries.size());
+    GLuint baseInstance = 0;
+    for (size_t i = 0; i < commands.size(); ++i)
+    {
+        const Geometry &geometry = *geometries[i];
+        commands[i] = {static_cast<GLuint>(geometry.count), 0, geometry.firstIndex, geometry.baseVertex, baseInstance};
+        baseInstance += capacities[i];
+    }
+
+    GLState::bindBuffer(GL_SHADER_STORAGE_BUFFER, instanceBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(instances.size() * sizeof(CullInstance)),
+                 instances.data(), GL_DYNAMIC_DRAW);
+    dirtyFirst.store(INVALID_INDEX, std::memory_order_relaxed);
+    dirtyLast.store(0, std::memory_order_relaxed);
+
+    auto commandBytes = static_cast<GLsizeiptr>(commands.size() * sizeof(DrawElementsIndirectCommand));
+    GLState::bindBuffer(GL_SHADER_STORAGE_BUFFER, commandBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, commandBytes, nullptr, GL_DYNAMIC_DRAW);
+
+    auto visibleBytes = static_cast<GLsizeiptr>(instances.size() * sizeof(GLuint));
+    GLState::bindBuffer(GL_ARRAY_BUFFER, visibleBuffer);
+    glBufferData(GL_ARRAY_BUFFER, visibleBytes, nullptr, GL_DYNAMIC_COPY);
+
+    geometries.front()->pool.bind();
+    glVertexAttribIPointer(CULLED_INSTANCE_LOCATION, 1, GL_UNSIGNED_INT, sizeof(GLuint), nullptr);
+    glVertexAttribDivisor(CULLED_INSTANCE_LOCATION, 1);
+
+    layoutDirty = false;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "timer.h"
+
+constexpr GLint BENCH_WIDTH = 1920, BENCH_HEIGHT = 1080;
+
+struct BenchmarkOptions
+{
+    GLuint frames = 0;
+    bool gui = false;
+    std::string output = "benchmark.json";
+
+    [[nodiscard]] bool enabled() const { return frames > 0; }
+};
+
+struct FrameSample
+{
+    GLdouble cpuTime = 0.0, gpuTime = 0.0;
+    std::array<GLdouble, PASS_COUNT> passTimes = {};
+    GLuint drawCalls = 0, visibleObjects = 0, culledObjects = 0;
+    GLuint64 triangles = 0;
+    bool gpuTimed = false;
+};
+
+class Benchmark
+{
+public:
+    Benchmark(GLint width, GLint height, GLuint frames, GpuTimer &timer);
+    Benchmark(const Benchmark &) = delete;
+    Benchmark &operator=(const Benchmark &) = delete;
+    ~Benchmark();
+
+    void beginFrame();
+    void endFrame();
+
+    [[nodiscard]] bool finished() const;
+    void writeReport(const std::string &path);
+
+    GLint width, height;
+
+private:
+    GLuint framebuffer = 0, colorBuffer = 0, depthBuffer = 0;
+    GLuint frames, currentFrame = 0;
+    GLuint64 firstTimerFrame = 0;
+
+    GpuTimer &timer;
+    std::vector<FrameSample> samples;
+    std::chrono::steady_clock::time_point frameStart;
+
+    void collectGpuTimes();
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "jobs.h"
+
+enum BlockFormat
+{
+    BLOCK_BC1,
+    BLOCK_BC3,
+    BLOCK_BC4,
+    BLOCK_BC5,
+    BLOCK_FORMAT_COUNT
+};
+
+constexpr const GLchar* BLOCK_FORMAT_NAMES[BLOCK_FORMAT_COUNT] = {"BC1", "BC3", "BC4", "BC5"};
+constexpr GLenum BLOCK_FORMAT_GL[BLOCK_FORMAT_COUNT] = {GL_COMPRESSED_RGB_S3TC_DXT1_EXT,
+                                                        GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, GL_COMPRESSED_RED_RGTC1,
+                                                        GL_COMPRESSED_RG_RGTC2};
+constexpr GLuint BLOCK_FORMAT_BYTES[BLOCK_FORMAT_COUNT] = {8, 16, 8, 16};
+
+struct CompressedLevel
+{
+    GLint width = 0, height = 0;
+    size_t offset = 0, size = 0;
+};
+
+struct CompressedImage
+{
+    BlockFormat format = BLOCK_BC1;
+    std::vector<CompressedLevel> levels;
+    std::vector<std::byte> data;
+
+    [[nodiscard]] bool valid() const { return !levels.empty(); }
+};
+
+BlockFormat chooseBlockFormat(const std::string &path, const std::string &type, GLint numChannels);
+bool blockFormatSupported(BlockFormat format);
+CompressedImage compressImage(const unsigned char* pixels, GLint width, GLint height, GLint numChannels,
+                              BlockFormat format, JobSystem* jobs = nullptr);
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+struct AABB
+{
+    glm::vec3 min = glm::vec3(0.0f), max = glm::vec3(0.0f);
+
+    [[nodiscard]] glm::vec3 center() const { return (min + max) * 0.5f; }
+    [[nodiscard]] glm::vec3 extents() const { return (max - min) * 0.5f; }
+    [[nodiscard]] GLfloat surfaceArea() const
+    {
+        glm::vec3 size = max - min;
+        return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+    }
+
+    [[nodiscard]] AABB transformed(const glm::mat4 &matrix) const;
+    void expand(const AABB &other);
+};
+
+struct BoundingSphere
+{
+    glm::vec3 center = glm::vec3(0.0f);
+    GLfloat radius = 0.0f;
+
+    [[nodiscard]] BoundingSphere transformed(const glm::mat4 &matrix) const;
+};
+
+struct Ray
+{
+    glm::vec3 origin = glm::vec3(0.0f), direction = glm::vec3(0.0f, 0.0f, -1.0f);
+    GLfloat maxDistance = std::numeric_limits<GLfloat>::max();
+
+    [[nodiscard]] bool intersects(const AABB &box, const glm::vec3 &inverseDirection, GLfloat &distance) const;
+};
+
+struct Bounds
+{
+    AABB box;
+    BoundingSphere sphere;
+
+    static Bounds fromPositions(const void* data, size_t count, size_t stride);
+    static Bounds fromBox(const AABB &box);
+};
+
+// Fixed-size traversal stack that spills onto the heap instead of dropping nodes on a degenerate tree.
+template<GLuint CAPACITY>
+class TraversalStack
+{
+public:
+    void push(GLuint node)
+    {
+        if (size < CAPACITY) fixed[size] = node;
+        else overflow.push_back(node);
+        ++size;
+    }
+
+    GLuint pop()
+    {
+        if (--size < CAPACITY) return fixed[size];
+
+        GLuint node = overflow.back();
+        overflow.pop_back();
+        return node;
+    }
+
+    [[nodiscard]] bool empty() const { return size == 0; }
+
+private:
+    GLuint fixed[CAPACITY];
+    std::vector<GLuint> overflow;
+    GLuint size = 0;
+};
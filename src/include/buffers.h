@@ -0,0 +1,166 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+enum UniformBlockBinding : GLuint
+{
+    FRAME_BLOCK_BINDING = 0,
+    LIGHT_BLOCK_BINDING = 1
+};
+
+struct FrameBlock
+{
+    glm::mat4 view, projection;
+    glm::vec4 viewPos;
+};
+
+struct LightBlock
+{
+    glm::vec4 lightPos, lightDirection, lightColor;
+    GLint lightType;
+    GLfloat spotLightAngle;
+    GLint enableAmbientLight, enableDiffuseLight, enableSpecularLight;
+    GLint padding[3];
+};
+
+struct InstanceData
+{
+    glm::mat4 model;
+    glm::mat3 normal;
+};
+
+struct IndirectDrawData
+{
+    glm::mat4 model;
+    glm::vec4 normal[3];
+};
+
+struct CullInstance
+{
+    glm::mat4 model;
+    glm::vec4 normal[3];
+    glm::vec4 center;
+    glm::vec3 extents;
+    GLuint command;
+};
+
+struct DrawElementsIndirectCommand
+{
+    GLuint count, instanceCount, firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+static_assert(sizeof(FrameBlock) == 144, "FrameBlock must match the std140 layout of the Frame block");
+static_assert(sizeof(LightBlock) == 80, "LightBlock must match the std140 layout of the Light block");
+static_assert(sizeof(InstanceData) == 25 * sizeof(GLfloat), "InstanceData must be tightly packed for attribute fetch");
+static_assert(sizeof(IndirectDrawData) == 112, "IndirectDrawData must match the std430 layout of the Draw struct");
+static_assert(sizeof(CullInstance) == 144, "CullInstance must match the std430 layout of the Instance struct");
+static_assert(sizeof(DrawElementsIndirectCommand) == 20, "DrawElementsIndirectCommand must match the GL layout");
+
+constexpr GLuint INSTANCE_MODEL_LOCATION = 4, INSTANCE_NORMAL_LOCATION = 8, DRAW_ID_LOCATION = 11,
+        CULLED_INSTANCE_LOCATION = 12;
+
+enum InstanceArrays : GLuint
+{
+    INSTANCE_ARRAYS_NONE = 0,
+    INSTANCE_ARRAYS_TRANSFORM = 1 << 0,
+    INSTANCE_ARRAYS_DRAW_ID = 1 << 1,
+    INSTANCE_ARRAYS_CULLED = 1 << 2
+};
+
+enum StorageBinding : GLuint
+{
+    DRAW_STORAGE_BINDING = 0,
+    CULL_INSTANCE_STORAGE_BINDING = 1,
+    CULL_COMMAND_STORAGE_BINDING = 2,
+    CULL_VISIBLE_STORAGE_BINDING = 3
+};
+
+class RingBuffer
+{
+public:
+    static constexpr GLuint FRAMES = 3;
+
+    struct Allocation
+    {
+        std::byte* data = nullptr;
+        GLintptr offset = 0;
+        GLsizeiptr size = 0;
+
+        [[nodiscard]] bool valid() const { return data != nullptr; }
+    };
+
+    explicit RingBuffer(GLsizeiptr requestedSize);
+    RingBuffer(const RingBuffer &) = delete;
+    RingBuffer &operator=(const RingBuffer &) = delete;
+    ~RingBuffer();
+
+    static bool supported();
+
+    void beginFrame();
+    void endFrame();
+    Allocation allocate(GLenum target, GLsizeiptr size);
+    void bindRange(GLenum target, GLuint index, const Allocation &allocation) const;
+
+    [[nodiscard]] GLsizeiptr frameCapacity() const { return frameSize; }
+    [[nodiscard]] GLsizeiptr lastFrameUsage() const { return used; }
+    [[nodiscard]] GLdouble lastWaitTime() const { return waitTime; }
+
+    GLuint ID = 0;
+
+private:
+    GLsizeiptr frameSize = 0;
+    GLsizeiptr uniformAlignment = 256, storageAlignment = 256;
+    std::byte* mapping = nullptr;
+    std::array<GLsync, FRAMES> fences{};
+    GLuint frame = 0;
+    std::atomic<GLsizeiptr> head = 0;
+    GLsizeiptr used = 0;
+    GLdouble waitTime = 0.0;
+};
+
+class UniformBuffer
+{
+public:
+    UniformBuffer(GLuint binding, GLsizeiptr size, RingBuffer* ring = nullptr);
+    UniformBuffer(const UniformBuffer &) = delete;
+    UniformBuffer &operator=(const UniformBuffer &) = delete;
+    ~UniformBuffer();
+
+    void update(const void* data, GLsizeiptr dataSize) const;
+    template<typename T>
+    void update(const T &block) const { update(&block, sizeof(T)); }
+
+    GLuint ID = 0, binding;
+    GLsizeiptr size;
+    RingBuffer* ring;
+};
+
+class InstanceBuffer
+{
+public:
+    InstanceBuffer();
+    InstanceBuffer(const InstanceBuffer &) = delete;
+    InstanceBuffer &operator=(const InstanceBuffer &) = delete;
+    ~InstanceBuffer();
+
+    void update(std::span<const glm::mat4> models);
+    void attach() const;
+
+    [[nodiscard]] GLsizei size() const { return count; }
+
+    GLuint ID = 0;
+
+private:
+    GLsizei count = 0;
+    GLsizeiptr capacity = 0;
+    std::vector<InstanceData> staging;
+};
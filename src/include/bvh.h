@@ -0,0 +1,146 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "bounds.h"
+#include "culling.h"
+#include "jobs.h"
+
+struct RayHit
+{
+    GLuint id = std::numeric_limits<GLuint>::max();
+    GLfloat distance = std::numeric_limits<GLfloat>::max();
+
+    [[nodiscard]] bool valid() const { return id != std::numeric_limits<GLuint>::max(); }
+};
+
+class SceneBVH
+{
+public:
+    static constexpr GLuint BINS = 16, MAX_LEAF_SIZE = 4, INVALID_ID = std::numeric_limits<GLuint>::max();
+    static constexpr GLfloat REBUILD_THRESHOLD = 1.5f;
+    static constexpr GLuint QUALITY_CHECK_INTERVAL = 30, MAX_DEPTH = 128;
+
+    explicit SceneBVH(JobSystem* jobs = nullptr);
+    SceneBVH(const SceneBVH &) = delete;
+    SceneBVH &operator=(const SceneBVH &) = delete;
+    ~SceneBVH();
+
+    void build(std::span<const AABB> objectBoxes);
+    void update(GLuint id, const AABB &box);
+    void setBox(GLuint id, const AABB &box) { boxes[id] = box; }
+    void refit();
+    void poll();
+
+    void queryFrustum(const Frustum &frustum, std::vector<GLuint> &result) const;
+    void queryRadius(const glm::vec3 &center, GLfloat radius, std::vector<GLuint> &result) const;
+    [[nodiscard]] GLuint nearest(const glm::vec3 &point,
+                                 GLfloat maxDistance = std::numeric_limits<GLfloat>::max()) const;
+
+    template<typename Intersect>
+    bool raycast(const Ray &ray, RayHit &hit, Intersect &&intersect) const;
+    bool raycast(const Ray &ray, RayHit &hit) const;
+
+    [[nodiscard]] GLfloat cost() const;
+    [[nodiscard]] GLfloat quality() const { return lastQuality; }
+    [[nodiscard]] size_t size() const { return boxes.size(); }
+    [[nodiscard]] size_t nodeCount() const { return tree.nodes.size(); }
+    [[nodiscard]] bool rebuilding() const { return pending != nullptr; }
+    [[nodiscard]] GLuint rebuildCount() const { return rebuilds; }
+
+private:
+    struct Node
+    {
+        AABB box;
+        GLuint left = 0, first = 0, count = 0;
+
+        [[nodiscard]] bool leaf() const { return left == 0; }
+    };
+
+    struct Tree
+    {
+        std::vector<Node> nodes;
+        std::vector<GLuint> indices, parents, leafOf;
+        GLfloat builtCost = 1.0f;
+    };
+
+    struct PendingBuild
+    {
+        std::vector<AABB> boxes;
+        Tree tree;
+        std::atomic<bool> done = false;
+    };
+
+    Tree tree;
+    std::vector<AABB> boxes;
+    JobSystem* jobs;
+    std::shared_ptr<PendingBuild> pending;
+
+    GLuint updatesSinceCheck = 0, framesSinceCheck = 0, rebuilds = 0;
+    GLfloat lastQuality = 1.0f;
+
+    static Tree buildTree(std::span<const AABB> objectBoxes, JobSystem* jobs);
+    static GLfloat treeCost(const Tree &bvh);
+    void refitNode(GLuint node);
+};
+
+template<typename Intersect>
+bool SceneBVH::raycast(const Ray &ray, RayHit &hit, Intersect &&intersect) const
+{
+    if (tree.nodes.empty()) return false;
+
+    glm::vec3 inverseDirection = 1.0f / ray.direction;
+    GLfloat closest = ray.maxDistance, entry = 0.0f;
+    if (!ray.intersects(tree.nodes[0].box, inverseDirection, entry) || entry > closest) return false;
+
+    TraversalStack<MAX_DEPTH> stack;
+    stack.push(0);
+
+    while (!stack.empty())
+    {
+        const Node &node = tree.nodes[stack.pop()];
+
+        if (node.leaf())
+        {
+            for (GLuint i = node.first; i < node.first + node.count; ++i)
+            {
+                GLuint id = tree.indices[i];
+                GLfloat distance = closest;
+
+                if (intersect(id, ray, distance) && distance < closest)
+                {
+                    closest = distance;
+                    hit = {id, distance};
+                }
+            }
+
+            continue;
+        }
+
+        GLfloat nearDistance = 0.0f, farDistance = 0.0f;
+        GLuint nearChild = node.left, farChild = node.left + 1;
+        bool nearHit = ray.intersects(tree.nodes[nearChild].box, inverseDirection, nearDistance) &&
+                       nearDistance <= closest;
+        bool farHit = ray.intersects(tree.nodes[farChild].box, inverseDirection, farDistance) &&
+                      farDistance <= closest;
+
+        if (nearHit && farHit && farDistance < nearDistance)
+        {
+            std::swap(nearChild, farChild);
+            std::swap(nearDistance, farDistance);
+        }
+
+        if (farHit) stack.push(farChild);
+        if (nearHit) stack.push(nearChild);
+    }
+
+    return hit.valid() && hit.distance <= ray.maxDistance;
+}
@@ -4,6 +4,8 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "bounds.h"
+
 constexpr GLfloat SPEED = 10.0f, SENSITIVITY = 0.1f, FOV = 45.0f, NEAR = 0.1f, FAR = 100.0f;
 
 enum CameraMovement
@@ -24,6 +26,7 @@ public:
 
     [[nodiscard]] glm::mat4 getViewMatrix() const;
     [[nodiscard]] glm::mat4 getProjectionMatrix(GLfloat aspectRatio, GLfloat fieldOfView) const;
+    [[nodiscard]] Ray getScreenRay(GLfloat x, GLfloat y, GLfloat width, GLfloat height) const;
 
     void processKeyboard(CameraMovement direction, GLdouble deltaTime);
     void processMouseMovement(GLfloat xOffset, GLfloat yOffset);
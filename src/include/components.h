@@ -0,0 +1,37 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "bounds.h"
+#include "geometry.h"
+#include "shader.h"
+
+struct Transform
+{
+    glm::vec3 position = glm::vec3(0.0f), rotation = glm::vec3(0.0f), scale = glm::vec3(1.0f);
+};
+
+struct WorldTransform
+{
+    glm::mat4 model = glm::mat4(1.0f);
+};
+
+struct MeshRef
+{
+    std::shared_ptr<Geometry> geometry;
+};
+
+struct MaterialRef
+{
+    std::shared_ptr<Shader> shader;
+};
+
+struct LevelOfDetail
+{
+    std::vector<std::shared_ptr<Geometry>> levels;
+    GLuint current = 0;
+};
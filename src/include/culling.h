@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "bounds.h"
+#include "jobs.h"
+
+enum Containment
+{
+    OUTSIDE,
+    INTERSECTING,
+    INSIDE
+};
+
+struct Frustum
+{
+    std::array<glm::vec4, 6> planes;
+
+    static Frustum fromMatrix(const glm::mat4 &viewProjection);
+
+    [[nodiscard]] Containment classify(const AABB &box) const;
+    [[nodiscard]] bool intersects(const AABB &box) const;
+    [[nodiscard]] bool intersects(const BoundingSphere &sphere) const;
+};
+
+class Culler
+{
+public:
+    static constexpr GLuint LANES = 8, PARALLEL_GROUPS = 256;
+
+    void clear();
+    void reserve(size_t count);
+    GLuint add(const AABB &box);
+    void update(GLuint index, const AABB &box);
+    void cull(const Frustum &frustum, JobSystem* jobs = nullptr);
+
+    [[nodiscard]] bool visible(GLuint index) const { return visibility[index] != 0; }
+    [[nodiscard]] std::span<const std::uint8_t> results() const { return visibility; }
+    [[nodiscard]] size_t size() const { return count; }
+    [[nodiscard]] GLuint visibleCount() const { return visibleObjects; }
+    [[nodiscard]] GLuint culledCount() const { return static_cast<GLuint>(count) - visibleObjects; }
+
+private:
+    std::vector<GLfloat> centerX, centerY, centerZ, extentX, extentY, extentZ;
+    std::vector<std::uint8_t> visibility;
+    size_t count = 0;
+    GLuint visibleObjects = 0;
+
+    GLuint cullRange(const Frustum &frustum, size_t first, size_t last);
+};
@@ -0,0 +1,271 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "jobs.h"
+
+struct Entity
+{
+    static constexpr GLuint INVALID_INDEX = std::numeric_limits<GLuint>::max();
+
+    GLuint index = INVALID_INDEX, generation = 0;
+
+    [[nodiscard]] bool valid() const { return index != INVALID_INDEX; }
+    bool operator==(const Entity &) const = default;
+};
+
+using ComponentMask = std::uint64_t;
+
+struct ComponentType
+{
+    size_t size = 0, alignment = 0;
+    void (*move)(void* destination, void* source) = nullptr;
+    void (*destroy)(void* component) = nullptr;
+};
+
+class ComponentRegistry
+{
+public:
+    static constexpr GLuint MAX_COMPONENTS = 64;
+
+    template<typename T>
+    static GLuint id()
+    {
+        static const GLuint value = add(ComponentType{
+                sizeof(T), alignof(T),
+                [](void* destination, void* source) { new(destination) T(std::move(*static_cast<T*>(source))); },
+                [](void* component) { static_cast<T*>(component)->~T(); }});
+        return value;
+    }
+
+    template<typename... Components>
+    static ComponentMask mask() { return (ComponentMask(0) | ... | (ComponentMask(1) << id<Components>())); }
+
+    static const ComponentType &type(GLuint id) { return types()[id]; }
+
+private:
+    static std::array<ComponentType, MAX_COMPONENTS> &types();
+    static GLuint add(const ComponentType &type);
+};
+
+class Archetype
+{
+public:
+    static constexpr size_t CHUNK_BYTES = 16 * 1024, CHUNK_ALIGNMENT = 64;
+
+    explicit Archetype(ComponentMask mask);
+    Archetype(const Archetype &) = delete;
+    Archetype &operator=(const Archetype &) = delete;
+    ~Archetype();
+
+    GLuint allocate(Entity entity);
+    Entity remove(GLuint row);
+
+    [[nodiscard]] void* component(GLuint id, GLuint row) const
+    {
+        return chunks[row / capacity].get() + offsets[id] + (row % capacity) * ComponentRegistry::type(id).size;
+    }
+
+    template<typename T>
+    [[nodiscard]] T* column(size_t chunk) const
+    {
+        return reinterpret_cast<T*>(chunks[chunk].get() + offsets[ComponentRegistry::id<std::remove_const_t<T>>()]);
+    }
+
+    [[nodiscard]] const Entity* entities(size_t chunk) const
+    {
+        return reinterpret_cast<const Entity*>(chunks[chunk].get());
+    }
+
+    [[nodiscard]] ComponentMask mask() const { return componentMask; }
+    [[nodiscard]] const std::vector<GLuint> &componentIds() const { return components; }
+    [[nodiscard]] GLuint size() const { return count; }
+    [[nodiscard]] size_t chunkCount() const { return chunks.size(); }
+    [[nodiscard]] GLuint chunkSize(size_t chunk) const
+    {
+        return std::min(capacity, count - static_cast<GLuint>(chunk) * capacity);
+    }
+
+private:
+    struct ChunkDeleter
+    {
+        void operator()(std::byte* chunk) const { ::operator delete[](chunk, std::align_val_t(CHUNK_ALIGNMENT)); }
+    };
+
+    ComponentMask componentMask;
+    std::vector<GLuint> components;
+    std::array<size_t, ComponentRegistry::MAX_COMPONENTS> offsets{};
+    GLuint capacity = 1, count = 0;
+    size_t chunkBytes = 0;
+    std::vector<std::unique_ptr<std::byte[], ChunkDeleter>> chunks;
+
+    Entity &entityAt(GLuint row) const
+    {
+        return reinterpret_cast<Entity*>(chunks[row / capacity].get())[row % capacity];
+    }
+};
+
+class EntityWorld
+{
+public:
+    EntityWorld() = default;
+    EntityWorld(const EntityWorld &) = delete;
+    EntityWorld &operator=(const EntityWorld &) = delete;
+
+    static EntityWorld &get();
+
+    template<typename... Components>
+    Entity create(Components &&... components);
+    void destroy(Entity entity);
+
+    template<typename T>
+    T &add(Entity entity, T component = T());
+    template<typename T>
+    void remove(Entity entity);
+
+    template<typename T>
+    [[nodiscard]] T &get(Entity entity) const
+    {
+        const Record &record = records[entity.index];
+        return *static_cast<T*>(record.archetype->component(ComponentRegistry::id<T>(), record.row));
+    }
+
+    template<typename T>
+    [[nodiscard]] bool has(Entity entity) const
+    {
+        return alive(entity) && records[entity.index].archetype->mask() & ComponentRegistry::mask<T>();
+    }
+
+    [[nodiscard]] bool alive(Entity entity) const
+    {
+        return entity.index < records.size() && records[entity.index].generation == entity.generation &&
+               records[entity.index].archetype;
+    }
+
+    template<typename... Components, typename Function>
+    void forEachChunk(Function &&function);
+    template<typename... Components, typename Function>
+    void forEach(Function &&function);
+    template<typename... Components, typename Function>
+    void parallelForEach(JobSystem &jobs, Function &&function);
+
+    [[nodiscard]] size_t size() const { return records.size() - freeIndices.size(); }
+    [[nodiscard]] size_t archetypeCount() const { return archetypes.size(); }
+
+private:
+    struct Record
+    {
+        Archetype* archetype = nullptr;
+        GLuint row = 0, generation = 0;
+    };
+
+    std::vector<Record> records;
+    std::vector<GLuint> freeIndices;
+    std::vector<std::unique_ptr<Archetype>> archetypes;
+    std::unordered_map<ComponentMask, Archetype*> archetypeLookup;
+
+    Archetype &archetype(ComponentMask mask);
+    Entity allocate(Archetype &archetype);
+    void release(Entity entity);
+    void migrate(Entity entity, Archetype &target);
+
+    template<typename... Components>
+    std::vector<std::pair<Archetype*, size_t>> matchingChunks() const;
+};
+
+template<typename... Components>
+Entity EntityWorld::create(Components &&... components)
+{
+    Archetype &target = archetype(ComponentRegistry::mask<std::decay_t<Components>...>());
+    Entity entity = allocate(target);
+
+    GLuint row = records[entity.index].row;
+    (new(target.component(ComponentRegistry::id<std::decay_t<Components>>(), row))
+            std::decay_t<Components>(std::forward<Components>(components)), ...);
+
+    return entity;
+}
+
+template<typename T>
+T &EntityWorld::add(Entity entity, T component)
+{
+    if (has<T>(entity)) return get<T>(entity) = std::move(component);
+
+    migrate(entity, archetype(records[entity.index].archetype->mask() | ComponentRegistry::mask<T>()));
+
+    const Record &record = records[entity.index];
+    return *new(record.archetype->component(ComponentRegistry::id<T>(), record.row)) T(std::move(component));
+}
+
+template<typename T>
+void EntityWorld::remove(Entity entity)
+{
+    if (!has<T>(entity)) return;
+
+    migrate(entity, archetype(records[entity.index].archetype->mask() & ~ComponentRegistry::mask<T>()));
+}
+
+template<typename... Components, typename Function>
+void EntityWorld::forEachChunk(Function &&function)
+{
+    for (auto [archetype, chunk]: matchingChunks<Components...>())
+    {
+        function(archetype->chunkSize(chunk), archetype->entities(chunk),
+                 archetype->template column<Components>(chunk)...);
+    }
+}
+
+template<typename... Components, typename Function>
+void EntityWorld::forEach(Function &&function)
+{
+    forEachChunk<Components...>([&](GLuint size, const Entity*, Components* ... columns)
+    {
+        for (GLuint i = 0; i < size; ++i) function(columns[i]...);
+    });
+}
+
+template<typename... Components, typename Function>
+void EntityWorld::parallelForEach(JobSystem &jobs, Function &&function)
+{
+    auto chunks = matchingChunks<Components...>();
+    jobs.parallelFor(chunks.size(), [&](size_t first, size_t last)
+    {
+        for (size_t i = first; i < last; ++i)
+        {
+            auto [archetype, chunk] = chunks[i];
+            GLuint size = archetype->chunkSize(chunk);
+            auto columns = std::make_tuple(archetype->template column<Components>(chunk)...);
+
+            for (GLuint row = 0; row < size; ++row)
+                std::apply([&](Components* ... column) { function(column[row]...); }, columns);
+        }
+    }, 1);
+}
+
+template<typename... Components>
+std::vector<std::pair<Archetype*, size_t>> EntityWorld::matchingChunks() const
+{
+    ComponentMask required = ComponentRegistry::mask<std::remove_const_t<Components>...>();
+
+    std::vector<std::pair<Archetype*, size_t>> chunks;
+    for (const auto &archetype: archetypes)
+    {
+        if ((archetype->mask() & required) != required) continue;
+        for (size_t chunk = 0; chunk < archetype->chunkCount(); ++chunk) chunks.emplace_back(archetype.get(), chunk);
+    }
+
+    return chunks;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <array>
+#include <map>
+#include <memory>
+#include <optional>
+#include <span>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "bounds.h"
+#include "picking.h"
+#include "buffers.h"
+#include "stats.h"
+#include "vertex.h"
+
+enum VertexFormat
+{
+    VERTEX_FORMAT_POSITION,
+    VERTEX_FORMAT_FULL,
+    VERTEX_FORMAT_COUNT
+};
+
+constexpr GLsizei VERTEX_FORMAT_STRIDES[VERTEX_FORMAT_COUNT] = {sizeof(glm::vec3), sizeof(Vertex)};
+constexpr const GLchar* VERTEX_FORMAT_NAMES[VERTEX_FORMAT_COUNT] = {"Position", "Full"};
+
+class FreeListAllocator
+{
+public:
+    explicit FreeListAllocator(GLuint capacity);
+
+    [[nodiscard]] std::optional<GLuint> allocate(GLuint count);
+    void free(GLuint offset, GLuint count);
+    void grow(GLuint newCapacity);
+
+    [[nodiscard]] GLuint capacity() const { return total; }
+    [[nodiscard]] GLuint used() const { return allocated; }
+    [[nodiscard]] size_t fragments() const { return blocks.size(); }
+
+private:
+    std::map<GLuint, GLuint> blocks;
+    GLuint total, allocated = 0;
+
+    void insertBlock(GLuint offset, GLuint count);
+};
+
+class GeometryPool;
+
+struct Geometry
+{
+    Geometry(GeometryPool &pool, GLint baseVertex, GLuint vertexCount, GLuint firstIndex, GLsizei count, GLenum mode);
+    Geometry(const Geometry &) = delete;
+    Geometry &operator=(const Geometry &) = delete;
+    ~Geometry();
+
+    void draw() const;
+    void drawInstanced(const InstanceBuffer &instances) const;
+
+    GeometryPool &pool;
+    GLint baseVertex;
+    GLuint vertexCount, firstIndex;
+    GLsizei count;
+    GLenum mode;
+    Bounds bounds;
+    std::shared_ptr<const TriangleBVH> triangles;
+};
+
+class GeometryPool
+{
+public:
+    static constexpr GLuint INITIAL_VERTICES = 1 << 16, INITIAL_INDICES = 1 << 18;
+
+    explicit GeometryPool(VertexFormat format);
+    GeometryPool(const GeometryPool &) = delete;
+    GeometryPool &operator=(const GeometryPool &) = delete;
+    ~GeometryPool();
+
+    std::shared_ptr<Geometry> allocate(const void* vertexData, GLuint vertexCount, std::span<const GLuint> indexData,
+                                       GLenum mode);
+    template<typename V>
+    std::shared_ptr<Geometry> allocate(std::span<const V> vertexData, std::span<const GLuint> indexData, GLenum mode)
+    {
+        return allocate(vertexData.data(), static_cast<GLuint>(vertexData.size()), indexData, mode);
+    }
+
+    void reserve(GLuint vertexCount, GLuint indexCount);
+    void release(const Geometry &geometry);
+    void bind(GLuint instanceArrays = INSTANCE_ARRAYS_NONE) const;
+
+    [[nodiscard]] const FreeListAllocator &vertices() const { return vertexAllocator; }
+    [[nodiscard]] const FreeListAllocator &indices() const { return indexAllocator; }
+
+    static GeometryPool &get(VertexFormat format);
+    static const GeometryPool* find(VertexFormat format) { return pools[format].get(); }
+    static void releaseAll();
+
+    const VertexFormat format;
+    GLuint VAO = 0, VBO = 0, EBO = 0;
+
+private:
+    FreeListAllocator vertexAllocator, indexAllocator;
+    mutable GLuint enabledArrays = INSTANCE_ARRAYS_NONE;
+
+    void setupAttributes() const;
+    static void growAllocator(FreeListAllocator &allocator, GLuint &buffer, GLsizeiptr elementSize, GLuint count);
+    static void growBuffer(GLuint &buffer, GLsizeiptr oldSize, GLsizeiptr newSize);
+
+    static inline std::array<std::unique_ptr<GeometryPool>, VERTEX_FORMAT_COUNT> pools;
+};
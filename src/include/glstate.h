@@ -0,0 +1,113 @@
+#pragma once
+
+#include <array>
+#include <limits>
+
+#include <GL/glew.h>
+
+enum GLStateCall
+{
+    CALL_PROGRAM,
+    CALL_VERTEX_ARRAY,
+    CALL_BUFFER,
+    CALL_BUFFER_BASE,
+    CALL_ACTIVE_TEXTURE,
+    CALL_TEXTURE,
+    CALL_SAMPLER,
+    CALL_CAPABILITY,
+    CALL_BLEND,
+    CALL_DEPTH,
+    CALL_VIEWPORT,
+    CALL_COUNT
+};
+
+constexpr const GLchar* GL_STATE_CALL_NAMES[CALL_COUNT] = {"Program", "Vertex Array", "Buffer", "Buffer Base",
+                                                           "Active Texture", "Texture", "Sampler", "Capability",
+                                                           "Blend", "Depth", "Viewport"};
+
+struct GLStateCounters
+{
+    std::array<GLuint, CALL_COUNT> issued = {}, elided = {};
+
+    [[nodiscard]] GLuint totalIssued() const;
+    [[nodiscard]] GLuint totalElided() const;
+};
+
+class GLState
+{
+public:
+    static constexpr GLuint TEXTURE_UNITS = 16, BUFFER_BINDINGS = 16;
+
+    static void useProgram(GLuint program);
+    static void bindVertexArray(GLuint vertexArray);
+    static void bindBuffer(GLenum target, GLuint buffer);
+    static void bindBufferBase(GLenum target, GLuint index, GLuint buffer);
+    static void bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+    static void bindTexture(GLuint unit, GLenum target, GLuint texture);
+    static void bindSampler(GLuint unit, GLuint sampler);
+    static void setEnabled(GLenum capability, bool enabled);
+    static void blendFunc(GLenum source, GLenum destination);
+    static void depthFunc(GLenum function);
+    static void depthMask(bool enabled);
+    static void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+    static void forgetProgram(GLuint program);
+    static void forgetVertexArray(GLuint vertexArray);
+    static void forgetBuffer(GLuint buffer);
+    static void forgetTexture(GLuint texture);
+    static void invalidate();
+
+    static void beginFrame();
+    [[nodiscard]] static const GLStateCounters &lastFrame() { return previous; }
+
+private:
+    static constexpr GLuint UNKNOWN = std::numeric_limits<GLuint>::max();
+
+    enum BufferTarget
+    {
+        TARGET_ARRAY,
+        TARGET_ELEMENT_ARRAY,
+        TARGET_UNIFORM,
+        TARGET_COPY_READ,
+        TARGET_COPY_WRITE,
+        TARGET_PIXEL_UNPACK,
+        TARGET_DRAW_INDIRECT,
+        TARGET_SHADER_STORAGE,
+        TARGET_DISPATCH_INDIRECT,
+        TARGET_COUNT
+    };
+
+    enum TextureTarget
+    {
+        TEXTURE_2D,
+        TEXTURE_2D_ARRAY,
+        TEXTURE_CUBE_MAP,
+        TEXTURE_TARGET_COUNT
+    };
+
+    enum Capability
+    {
+        CAPABILITY_DEPTH_TEST,
+        CAPABILITY_BLEND,
+        CAPABILITY_CULL_FACE,
+        CAPABILITY_SCISSOR_TEST,
+        CAPABILITY_COUNT
+    };
+
+    static inline GLuint program = UNKNOWN, vertexArray = UNKNOWN, activeUnit = UNKNOWN;
+    static inline std::array<GLuint, TARGET_COUNT> buffers = {};
+    static inline std::array<std::array<GLuint, BUFFER_BINDINGS>, TARGET_COUNT> bufferBases = {};
+    static inline std::array<std::array<GLuint, TEXTURE_TARGET_COUNT>, TEXTURE_UNITS> textures = {};
+    static inline std::array<GLuint, TEXTURE_UNITS> samplers = {};
+    static inline std::array<GLuint, CAPABILITY_COUNT> capabilities = {};
+    static inline std::array<GLuint, 2> blend = {UNKNOWN, UNKNOWN};
+    static inline GLuint depthFunction = UNKNOWN, depthWrite = UNKNOWN;
+    static inline std::array<GLint, 4> viewportRect = {};
+    static inline bool viewportKnown = false;
+    static inline GLStateCounters current, previous;
+
+    static bool track(GLStateCall call, GLuint &cached, GLuint value);
+    static GLint bufferTarget(GLenum target);
+    static GLint textureTarget(GLenum target);
+    static GLint capabilityIndex(GLenum capability);
+};
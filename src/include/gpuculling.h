@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "bounds.h"
+#include "buffers.h"
+#include "culling.h"
+#include "geometry.h"
+#include "shader.h"
+
+class DepthPyramid
+{
+public:
+    DepthPyramid() = default;
+    DepthPyramid(const DepthPyramid &) = delete;
+    DepthPyramid &operator=(const DepthPyramid &) = delete;
+    ~DepthPyramid();
+
+    void build(const Shader &reduce, GLsizei width, GLsizei height);
+
+    [[nodiscard]] bool valid() const { return texture != 0; }
+
+    GLuint texture = 0;
+
+private:
+    GLuint depthCopy = 0;
+    GLsizei width = 0, height = 0, levels = 0;
+
+    void resize(GLsizei newWidth, GLsizei newHeight);
+};
+
+class GpuCuller
+{
+public:
+    static constexpr GLuint INVALID_INDEX = 0xFFFFFFFF, GROUP_SIZE = 64, PYRAMID_GROUP_SIZE = 8;
+
+    GpuCuller(std::shared_ptr<Shader> cullShader, std::shared_ptr<Shader> reduceShader,
+              std::shared_ptr<Shader> drawShader);
+    GpuCuller(const GpuCuller &) = delete;
+    GpuCuller &operator=(const GpuCuller &) = delete;
+    ~GpuCuller();
+
+    static bool supported();
+
+    GLuint add(const Geometry &geometry, const glm::mat4 &model, const AABB &localBox);
+    void update(GLuint index, const glm::mat4 &model);
+    void cull(const Frustum &frustum, bool occlusion);
+    void draw();
+    void buildPyramid(const glm::mat4 &viewProjection, GLsizei width, GLsizei height);
+
+    [[nodiscard]] size_t size() const { return instances.size(); }
+    [[nodiscard]] size_t commandCount() const { return commands.size(); }
+
+    const std::shared_ptr<Shader> drawShader;
+
+private:
+    std::shared_ptr<Shader> cullShader, reduceShader;
+    Uniform<GLuint> instanceCountUniform;
+    Uniform<glm::vec4> planesUniform;
+    Uniform<bool> occlusionUniform;
+    Uniform<glm::mat4> pyramidViewProjectionUniform;
+
+    std::vector<CullInstance> instances;
+    std::vector<const Geometry*> geometries;
+    std::vector<DrawElementsIndirectCommand> commands;
+    std::vector<GLuint> capacities;
+    GLuint instanceBuffer = 0, commandBuffer = 0, visibleBuffer = 0;
+    std::atomic<GLuint> dirtyFirst = INVALID_INDEX, dirtyLast = 0;
+    bool layoutDirty = false;
+
+    DepthPyramid pyramid;
+    glm::mat4 pyramidViewProjection = glm::mat4(1.0f);
+
+    void markDirty(GLuint index);
+    void rebuildCommands();
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <memory>
+#include <span>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "buffers.h"
+#include "jobs.h"
+#include "renderqueue.h"
+#include "shader.h"
+
+class IndirectRenderer
+{
+public:
+    explicit IndirectRenderer(std::shared_ptr<Shader> shader, RingBuffer* ring = nullptr);
+    IndirectRenderer(const IndirectRenderer &) = delete;
+    IndirectRenderer &operator=(const IndirectRenderer &) = delete;
+    ~IndirectRenderer();
+
+    static bool supported();
+
+    void draw(std::span<const DrawPacket> packets, JobSystem* jobs = nullptr);
+
+    const std::shared_ptr<Shader> shader;
+
+private:
+    RingBuffer* ring;
+    GLuint commandBuffer = 0, drawBuffer = 0, drawIdBuffer = 0;
+    GLsizeiptr commandCapacity = 0, drawCapacity = 0;
+    GLuint drawIdCapacity = 0;
+    std::vector<DrawElementsIndirectCommand> commands;
+    std::vector<IndirectDrawData> draws;
+    std::vector<GLuint> attachedArrays;
+
+    void reserveDrawIds(GLuint count);
+    void attachDrawIds(const GeometryPool &pool);
+    static void upload(GLenum target, GLuint buffer, GLsizeiptr &capacity, const void* data, GLsizeiptr size);
+};
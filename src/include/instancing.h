@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "buffers.h"
+#include "objects.h"
+
+class InstanceBatch
+{
+public:
+    InstanceBatch(std::vector<std::shared_ptr<Geometry>> geometries, std::shared_ptr<Shader> shader);
+    InstanceBatch(const InstanceBatch &) = delete;
+    InstanceBatch &operator=(const InstanceBatch &) = delete;
+
+    void add(const glm::mat4 &model);
+    void clear();
+    void draw();
+
+    [[nodiscard]] GLsizei size() const { return static_cast<GLsizei>(models.size()); }
+
+    const std::vector<std::shared_ptr<Geometry>> geometries;
+    const std::shared_ptr<Shader> shader;
+
+private:
+    InstanceBuffer instances;
+    std::vector<glm::mat4> models;
+    bool dirty = false;
+};
+
+class InstanceRenderer
+{
+public:
+    void submit(Object &object);
+    void clear();
+    void draw();
+
+    [[nodiscard]] size_t batchCount() const { return batches.size(); }
+    [[nodiscard]] size_t instanceCount() const;
+
+private:
+    std::map<std::pair<std::uintptr_t, const Shader*>, std::unique_ptr<InstanceBatch>> batches;
+};
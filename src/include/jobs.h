@@ -0,0 +1,136 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct Job
+{
+    std::function<void()> function;
+    class JobCounter* counter = nullptr;
+};
+
+class JobCounter
+{
+public:
+    JobCounter() = default;
+    JobCounter(const JobCounter &) = delete;
+    JobCounter &operator=(const JobCounter &) = delete;
+
+    [[nodiscard]] bool done() const { return value.load(std::memory_order_acquire) == 0; }
+
+private:
+    friend class JobSystem;
+
+    std::atomic<std::uint32_t> value = 0;
+    std::mutex mutex;
+    std::vector<Job*> continuations;
+};
+
+// The cache-line alignment pads the deque on purpose, which MSVC reports as C4324 under /W4 /WX.
+#ifdef _MSC_VER
+#pragma warning(push)
+#pragma warning(disable: 4324)
+#endif
+
+class WorkStealingDeque
+{
+public:
+    static constexpr std::int64_t CAPACITY = 1 << 12;
+
+    WorkStealingDeque() = default;
+    WorkStealingDeque(const WorkStealingDeque &) = delete;
+    WorkStealingDeque &operator=(const WorkStealingDeque &) = delete;
+
+    bool push(Job* job);
+    Job* pop();
+    Job* steal();
+
+private:
+    alignas(64) std::atomic<std::int64_t> top = 0;
+    alignas(64) std::atomic<std::int64_t> bottom = 0;
+    alignas(64) std::array<std::atomic<Job*>, CAPACITY> buffer{};
+};
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+class JobSystem
+{
+public:
+    static constexpr size_t CHUNKS_PER_THREAD = 4;
+
+    explicit JobSystem(unsigned int threads = std::max(2u, std::thread::hardware_concurrency()) - 1);
+    JobSystem(const JobSystem &) = delete;
+    JobSystem &operator=(const JobSystem &) = delete;
+    ~JobSystem();
+
+    static JobSystem &get();
+
+    void submit(std::function<void()> function, JobCounter* counter = nullptr);
+    void submitAfter(JobCounter &dependency, std::function<void()> function, JobCounter* counter = nullptr);
+    void wait(JobCounter &counter);
+
+    template<typename Body>
+    void parallelFor(size_t count, Body &&body, size_t minChunk = 64);
+
+    void runOnMainThread(std::function<void()> function);
+    void runMainThreadJobs(size_t maxJobs = std::numeric_limits<size_t>::max());
+
+    [[nodiscard]] size_t size() const { return workers.size(); }
+    [[nodiscard]] size_t concurrency() const { return workers.size() + 1; }
+
+private:
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<WorkStealingDeque>> deques;
+
+    std::mutex injectionMutex;
+    std::vector<Job*> injection;
+
+    std::mutex sleepMutex;
+    std::condition_variable sleepCondition;
+    std::atomic<std::uint32_t> queued = 0, sleeping = 0;
+    std::atomic<bool> stopping = false;
+
+    std::mutex mainThreadMutex;
+    std::vector<std::function<void()>> mainThreadJobs;
+
+    void schedule(Job* job);
+    Job* findJob(size_t self);
+    void execute(Job* job);
+    void run(size_t index);
+};
+
+template<typename Body>
+void JobSystem::parallelFor(size_t count, Body &&body, size_t minChunk)
+{
+    if (count == 0) return;
+
+    size_t chunks = std::clamp(count / std::max<size_t>(minChunk, 1), size_t(1), concurrency() * CHUNKS_PER_THREAD);
+    if (chunks == 1)
+    {
+        body(size_t(0), count);
+        return;
+    }
+
+    size_t chunkSize = (count + chunks - 1) / chunks;
+    JobCounter counter;
+
+    for (size_t begin = chunkSize; begin < count; begin += chunkSize)
+    {
+        size_t end = std::min(count, begin + chunkSize);
+        submit([&body, begin, end] { body(begin, end); }, &counter);
+    }
+
+    body(size_t(0), std::min(count, chunkSize));
+    wait(counter);
+}
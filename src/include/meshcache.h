@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "optimizer.h"
+#include "vertex.h"
+
+struct TextureRef
+{
+    std::string path, type;
+};
+
+struct MeshData
+{
+    std::vector<Vertex> vertices;
+    std::vector<GLuint> indices;
+    std::vector<TextureRef> textures;
+    glm::vec3 boundsMin = glm::vec3(0.0f), boundsMax = glm::vec3(0.0f);
+    GLuint materialIndex = 0;
+    OptimizationReport optimization;
+
+    void computeBounds();
+};
+
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::string &path);
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    ~MappedFile();
+
+    [[nodiscard]] bool isOpen() const { return data != nullptr; }
+    [[nodiscard]] const std::uint8_t* bytes() const { return data; }
+    [[nodiscard]] std::size_t size() const { return length; }
+
+private:
+    const std::uint8_t* data = nullptr;
+    std::size_t length = 0;
+
+    #ifdef _WIN32
+    void* file = nullptr;
+    void* mapping = nullptr;
+    #endif
+};
+
+class MeshCache
+{
+public:
+    static constexpr std::uint32_t MAGIC = 0x434D5447, VERSION = 2;
+
+    struct Header
+    {
+        std::uint32_t magic, version;
+        std::uint64_t sourceHash;
+        std::uint32_t importFlags, vertexSize;
+        std::uint32_t meshCount, textureCount;
+    };
+
+    struct Entry
+    {
+        std::uint64_t vertexOffset, indexOffset;
+        std::uint32_t vertexCount, indexCount;
+        std::uint32_t firstTexture, textureCount;
+        std::uint32_t materialIndex, padding;
+        GLfloat boundsMin[3], boundsMax[3];
+        GLfloat acmrBefore, acmrAfter, atvrBefore, atvrAfter;
+    };
+
+    struct TextureEntry
+    {
+        std::uint32_t pathOffset, pathLength, typeOffset, typeLength;
+    };
+
+    explicit MeshCache(const std::string &path);
+
+    [[nodiscard]] bool matches(std::uint64_t sourceHash, GLuint importFlags) const;
+    [[nodiscard]] std::uint32_t meshCount() const { return header()->meshCount; }
+    [[nodiscard]] const Entry &entry(std::uint32_t mesh) const;
+    [[nodiscard]] std::span<const Vertex> vertices(std::uint32_t mesh) const;
+    [[nodiscard]] std::span<const GLuint> indices(std::uint32_t mesh) const;
+    [[nodiscard]] std::vector<TextureRef> textures(std::uint32_t mesh) const;
+
+    static std::string pathFor(const std::string &sourcePath);
+    static std::uint64_t hashFile(const std::string &path);
+    static bool write(const std::string &path, std::uint64_t sourceHash, GLuint importFlags,
+                      const std::vector<MeshData> &meshes);
+
+private:
+    MappedFile file;
+
+    [[nodiscard]] const Header* header() const { return reinterpret_cast<const Header*>(file.bytes()); }
+    [[nodiscard]] const TextureEntry* textureEntries() const;
+    [[nodiscard]] const GLchar* strings() const;
+};
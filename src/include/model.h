@@ -1,6 +1,8 @@
 #pragma once
 
 #include <iostream>
+#include <memory>
+#include <span>
 #include <string>
 #include <vector>
 #include <fstream>
@@ -19,42 +21,56 @@
 #include "shader.h"
 #include "texture.h"
 #include "objects.h"
+#include "vertex.h"
+#include "meshcache.h"
 
-struct Vertex
-{
-    glm::vec3 position, normal, color;
-    glm::vec2 texCoords;
-};
+constexpr GLuint DEFAULT_IMPORT_FLAGS = aiProcess_Triangulate | aiProcess_FlipUVs;
 
 class Mesh
 {
 public:
-    std::vector<Vertex> vertices;
-    std::vector<GLuint> indices;
-    std::vector<Texture> textures;
+    std::span<const Vertex> vertices;
+    std::span<const GLuint> indices;
+    std::vector<std::shared_ptr<Texture>> textures;
 
-    Mesh(std::vector<Vertex> vertices, std::vector<GLuint> indices, std::vector<Texture> textures);
+    Mesh(std::vector<Vertex> vertices, std::vector<GLuint> indices, std::vector<std::shared_ptr<Texture>> textures);
+    Mesh(std::shared_ptr<const MeshCache> cache, std::uint32_t mesh, std::vector<std::shared_ptr<Texture>> textures);
+    void resolveUniforms(const Shader &shader);
     void draw(Shader &shader);
 
+    [[nodiscard]] bool valid() const { return geometry != nullptr; }
+    [[nodiscard]] const Bounds &bounds() const { return geometry->bounds; }
+    [[nodiscard]] const std::shared_ptr<Geometry> &sharedGeometry() const { return geometry; }
+    [[nodiscard]] const TriangleBVH &triangles() const;
+
 private:
-    GLuint VAO, VBO, EBO;
-    void setupMesh();
+    std::shared_ptr<const void> source;
+    std::shared_ptr<Geometry> geometry;
+    std::vector<Uniform<GLint>> samplerUniforms;
+    void bindTextures(Shader* shader);
+    void setupMesh(std::span<const Vertex> vertexData, std::span<const GLuint> indexData);
 };
 
 class Model : public Object
 {
 public:
-    explicit Model(const GLchar* path, Shader &shader);
+    explicit Model(const GLchar* path, std::shared_ptr<Shader> shader, GLuint importFlags = DEFAULT_IMPORT_FLAGS);
     void draw() override;
+    [[nodiscard]] std::vector<std::shared_ptr<Geometry>> instanceGeometries() const override;
+    [[nodiscard]] std::uintptr_t geometryKey() const override { return reinterpret_cast<std::uintptr_t>(this); }
+    bool raycast(const Ray &ray, PickResult &result) const override;
 
 private:
     std::vector<Mesh> meshes;
     std::string directory;
-    std::vector<Texture> texturesLoaded;
+    std::vector<std::shared_ptr<Texture>> texturesLoaded;
 
-    void loadModel(const std::string &path);
-    void processNode(aiNode* node, const aiScene* scene);
-    Mesh processMesh(aiMesh* mesh, const aiScene* scene);
+    void loadModel(const std::string &path, GLuint importFlags);
+    bool loadCache(const std::string &cachePath, std::uint64_t sourceHash, GLuint importFlags);
+    static void processNode(const aiNode* node, const aiScene* scene, std::vector<const aiMesh*> &work);
+    static MeshData processMesh(const aiMesh* mesh, const aiScene* scene);
 
-    std::vector<Texture> loadMaterialTextures(aiMaterial* mat, aiTextureType type, const std::string &typeName);
+    static std::vector<TextureRef> getMaterialTextures(aiMaterial* mat, aiTextureType type,
+                                                       const std::string &typeName);
+    std::vector<std::shared_ptr<Texture>> loadTextures(const std::vector<TextureRef> &refs);
 };
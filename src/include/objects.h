@@ -1,5 +1,9 @@
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
 #include <vector>
 
 #include <GL/glew.h>
@@ -9,66 +13,97 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "buffers.h"
+#include "components.h"
+#include "ecs.h"
+#include "geometry.h"
+#include "picking.h"
+#include "primitives.h"
 #include "shader.h"
+#include "stats.h"
 
 class Object
 {
 public:
-    explicit Object(Shader &shader);
-    ~Object();
+    explicit Object(std::shared_ptr<Shader> shader, std::shared_ptr<Geometry> geometry = nullptr);
+    Object(const Object &) = delete;
+    Object &operator=(const Object &) = delete;
+    virtual ~Object();
 
     virtual void draw() = 0;
+    [[nodiscard]] virtual std::vector<std::shared_ptr<Geometry>> instanceGeometries() const;
+    [[nodiscard]] virtual std::uintptr_t geometryKey() const { return reinterpret_cast<std::uintptr_t>(geometry()); }
+
+    [[nodiscard]] Entity entity() const { return handle; }
+    [[nodiscard]] Transform &transform() const { return world.get<Transform>(handle); }
+    [[nodiscard]] glm::mat4 &model() const { return world.get<WorldTransform>(handle).model; }
+    [[nodiscard]] const std::shared_ptr<Shader> &shader() const { return world.get<MaterialRef>(handle).shader; }
+    [[nodiscard]] Geometry* geometry() const
+    {
+        return world.has<MeshRef>(handle) ? world.get<MeshRef>(handle).geometry.get() : nullptr;
+    }
+    [[nodiscard]] GLuint lod() const
+    {
+        return world.has<LevelOfDetail>(handle) ? world.get<LevelOfDetail>(handle).current : 0;
+    }
+
+    [[nodiscard]] const Bounds &localBounds() const { return world.get<Bounds>(handle); }
+    [[nodiscard]] AABB worldBox() const { return localBounds().box.transformed(model()); }
+    [[nodiscard]] BoundingSphere worldSphere() const { return localBounds().sphere.transformed(model()); }
 
-    glm::vec3 position = glm::vec3(0.0f), rotation = glm::vec3(0.0f), scale = glm::vec3(1.0f);
-    glm::mat4 model = glm::mat4(1.0f);
-    GLuint VAO = 0, VBO = 0, EBO = 0;
+    void updateModel();
 
-    Shader shader;
+    virtual bool raycast(const Ray &ray, PickResult &result) const;
 
-    std::vector<glm::vec3> vertices;
-    std::vector<GLuint> indices;
+protected:
+    EntityWorld &world;
+    Entity handle;
+    Uniform<glm::mat4> modelUniform;
 
-    void updateModel();
+    bool raycastTriangles(const TriangleBVH &triangles, GLuint mesh, const Ray &ray, PickResult &result) const;
 };
 
+void selectLods(EntityWorld &world, const glm::vec3 &cameraPosition, GLfloat projectionScale,
+                JobSystem* jobs = nullptr);
+
 class Cube : public Object
 {
 public:
-    explicit Cube(Shader &shader);
+    explicit Cube(std::shared_ptr<Shader> shader);
     void draw() override;
 };
 
 class Sphere : public Object
 {
 public:
-    explicit Sphere(Shader &shader);
+    explicit Sphere(std::shared_ptr<Shader> shader);
     void draw() override;
 };
 
 class Cylinder : public Object
 {
 public:
-    explicit Cylinder(Shader &shader);
+    explicit Cylinder(std::shared_ptr<Shader> shader);
     void draw() override;
 };
 
 class Cone : public Object
 {
 public:
-    explicit Cone(Shader &shader);
+    explicit Cone(std::shared_ptr<Shader> shader);
     void draw() override;
 };
 
 class Torus : public Object
 {
 public:
-    explicit Torus(Shader &shader);
+    explicit Torus(std::shared_ptr<Shader> shader);
     void draw() override;
 };
 
 class Plane : public Object
 {
 public:
-    explicit Plane(Shader &shader);
+    explicit Plane(std::shared_ptr<Shader> shader);
     void draw() override;
 };
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <vector>
+
+#include "vertex.h"
+
+struct CacheStats
+{
+    GLfloat acmr = 0.0f, atvr = 0.0f;
+};
+
+struct OptimizationReport
+{
+    GLuint verticesBefore = 0, verticesAfter = 0;
+    CacheStats before, after;
+};
+
+namespace MeshOptimizer
+{
+    constexpr GLuint SIMULATED_CACHE_SIZE = 16;
+
+    CacheStats analyzeVertexCache(const std::vector<GLuint> &indices, GLuint vertexCount,
+                                  GLuint cacheSize = SIMULATED_CACHE_SIZE);
+
+    void weldVertices(std::vector<Vertex> &vertices, std::vector<GLuint> &indices);
+    void optimizeVertexCache(std::vector<GLuint> &indices, GLuint vertexCount);
+    void optimizeOverdraw(std::vector<GLuint> &indices, const std::vector<Vertex> &vertices, GLfloat threshold = 1.05f);
+    void optimizeVertexFetch(std::vector<Vertex> &vertices, std::vector<GLuint> &indices);
+
+    OptimizationReport optimize(std::vector<Vertex> &vertices, std::vector<GLuint> &indices);
+}
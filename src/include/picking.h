@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "bounds.h"
+#include "vertex.h"
+
+class Object;
+
+struct TriangleHit
+{
+    static constexpr GLuint INVALID_TRIANGLE = std::numeric_limits<GLuint>::max();
+
+    GLuint triangle = INVALID_TRIANGLE;
+    GLfloat distance = std::numeric_limits<GLfloat>::max();
+    glm::vec2 barycentrics = glm::vec2(0.0f);
+
+    [[nodiscard]] bool valid() const { return triangle != INVALID_TRIANGLE; }
+};
+
+struct PickResult
+{
+    const Object* object = nullptr;
+    GLuint mesh = 0;
+    TriangleHit hit;
+    glm::vec3 position = glm::vec3(0.0f);
+
+    [[nodiscard]] bool valid() const { return object != nullptr; }
+};
+
+class TriangleBVH
+{
+public:
+    static constexpr GLuint WIDTH = 4, BINS = 16, MAX_LEAF_SIZE = 4, STACK_SIZE = 256;
+
+    TriangleBVH(std::span<const Vertex> vertices, std::span<const GLuint> indices);
+    TriangleBVH(const TriangleBVH &) = delete;
+    TriangleBVH &operator=(const TriangleBVH &) = delete;
+
+    bool raycast(const Ray &ray, TriangleHit &hit) const;
+
+    [[nodiscard]] size_t triangleCount() const { return triangles; }
+    [[nodiscard]] size_t nodeCount() const { return nodes.size(); }
+
+private:
+    static constexpr GLuint LEAF_FLAG = 0x80000000u, EMPTY_CHILD = std::numeric_limits<GLuint>::max();
+
+    struct alignas(16) Node
+    {
+        GLfloat minX[WIDTH], minY[WIDTH], minZ[WIDTH], maxX[WIDTH], maxY[WIDTH], maxZ[WIDTH];
+        GLuint children[WIDTH];
+    };
+
+    struct alignas(16) TriangleBlock
+    {
+        GLfloat originX[WIDTH], originY[WIDTH], originZ[WIDTH];
+        GLfloat edge1X[WIDTH], edge1Y[WIDTH], edge1Z[WIDTH], edge2X[WIDTH], edge2Y[WIDTH], edge2Z[WIDTH];
+        GLuint ids[WIDTH];
+    };
+
+    struct BuildState;
+
+    std::vector<Node> nodes;
+    std::vector<TriangleBlock> blocks;
+    size_t triangles = 0;
+
+    void buildNode(BuildState &state, GLuint node, GLuint first, GLuint count);
+    GLuint buildLeaf(const BuildState &state, GLuint first, GLuint count);
+    static GLuint split(BuildState &state, GLuint first, GLuint count);
+
+    static GLint intersectNode(const Node &node, const Ray &ray, const glm::vec3 &inverseDirection, GLfloat closest,
+                               GLfloat* distances);
+    static GLint intersectBlock(const TriangleBlock &block, const Ray &ray, GLfloat closest, GLfloat* t, GLfloat* u,
+                                GLfloat* v);
+};
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <array>
+#include <utility>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "vertex.h"
+
+constexpr std::array<GLuint, 4> LOD_SEGMENTS = {64, 32, 16, 8};
+constexpr GLuint LOD_COUNT = LOD_SEGMENTS.size();
+constexpr GLfloat LOD_FULL_DETAIL_PIXELS = 512.0f;
+
+namespace Trig
+{
+    constexpr GLdouble PI = 3.14159265358979323846;
+
+    constexpr GLdouble sine(GLdouble x)
+    {
+        while (x > PI) x -= 2.0 * PI;
+        while (x < -PI) x += 2.0 * PI;
+
+        GLdouble term = x, sum = x;
+        for (GLint n = 1; n < 12; ++n)
+        {
+            term *= -x * x / static_cast<GLdouble>((2 * n) * (2 * n + 1));
+            sum += term;
+        }
+
+        return sum;
+    }
+
+    constexpr GLdouble cosine(GLdouble x) { return sine(x + PI / 2.0); }
+}
+
+template<GLuint SEGMENTS>
+struct TrigTable
+{
+    std::array<GLfloat, SEGMENTS + 1> sin = {}, cos = {};
+
+    constexpr TrigTable()
+    {
+        for (GLuint i = 0; i < SEGMENTS; ++i)
+        {
+            GLdouble angle = 2.0 * Trig::PI * static_cast<GLdouble>(i) / static_cast<GLdouble>(SEGMENTS);
+            sin[i] = static_cast<GLfloat>(Trig::sine(angle));
+            cos[i] = static_cast<GLfloat>(Trig::cosine(angle));
+        }
+
+        sin[SEGMENTS] = sin[0];
+        cos[SEGMENTS] = cos[0];
+    }
+};
+
+template<GLuint SEGMENTS>
+inline constexpr TrigTable<SEGMENTS> TRIG_TABLE;
+
+struct PrimitiveMesh
+{
+    std::vector<Vertex> vertices;
+    std::vector<GLuint> indices;
+};
+
+struct SphereSurface
+{
+    template<GLuint SEGMENTS>
+    static void point(GLuint x, GLuint y, Vertex &vertex)
+    {
+        constexpr const auto &around = TRIG_TABLE<SEGMENTS>;
+        constexpr const auto &half = TRIG_TABLE<SEGMENTS * 2>;
+
+        vertex.normal = glm::vec3(around.cos[x] * half.sin[y], -half.cos[y], around.sin[x] * half.sin[y]);
+        vertex.position = vertex.normal;
+    }
+};
+
+struct CylinderSurface
+{
+    template<GLuint SEGMENTS>
+    static void point(GLuint x, GLuint y, Vertex &vertex)
+    {
+        constexpr const auto &around = TRIG_TABLE<SEGMENTS>;
+        GLfloat height = static_cast<GLfloat>(y) / static_cast<GLfloat>(SEGMENTS) * 2.0f - 1.0f;
+
+        vertex.position = glm::vec3(around.cos[x], height, around.sin[x]);
+        vertex.normal = glm::vec3(around.cos[x], 0.0f, around.sin[x]);
+    }
+};
+
+struct ConeSurface
+{
+    template<GLuint SEGMENTS>
+    static void point(GLuint x, GLuint y, Vertex &vertex)
+    {
+        constexpr const auto &around = TRIG_TABLE<SEGMENTS>;
+        GLfloat segment = static_cast<GLfloat>(y) / static_cast<GLfloat>(SEGMENTS);
+
+        vertex.position = glm::vec3(around.cos[x] * (1.0f - segment), segment * 2.0f - 1.0f,
+                                    around.sin[x] * (1.0f - segment));
+        vertex.normal = glm::normalize(glm::vec3(2.0f * around.cos[x], 1.0f, 2.0f * around.sin[x]));
+    }
+};
+
+struct TorusSurface
+{
+    static constexpr GLfloat MAJOR_RADIUS = 0.75f, MINOR_RADIUS = 0.25f;
+
+    template<GLuint SEGMENTS>
+    static void point(GLuint x, GLuint y, Vertex &vertex)
+    {
+        constexpr const auto &around = TRIG_TABLE<SEGMENTS>;
+
+        vertex.normal = glm::vec3(around.cos[y] * around.cos[x], around.sin[y], around.cos[y] * around.sin[x]);
+        vertex.position = glm::vec3(around.cos[x], 0.0f, around.sin[x]) * MAJOR_RADIUS + vertex.normal * MINOR_RADIUS;
+    }
+};
+
+template<typename Surface, GLuint SEGMENTS>
+PrimitiveMesh generateSurface()
+{
+    PrimitiveMesh mesh;
+    mesh.vertices.reserve((SEGMENTS + 1) * (SEGMENTS + 1));
+    mesh.indices.reserve(SEGMENTS * SEGMENTS * 6);
+
+    for (GLuint y = 0; y <= SEGMENTS; ++y)
+        for (GLuint x = 0; x <= SEGMENTS; ++x)
+        {
+            Vertex vertex = {};
+            Surface::template point<SEGMENTS>(x, y, vertex);
+            vertex.color = glm::vec3(1.0f);
+            vertex.texCoords = glm::vec2(static_cast<GLfloat>(x), static_cast<GLfloat>(y)) /
+                               static_cast<GLfloat>(SEGMENTS);
+
+            mesh.vertices.push_back(vertex);
+        }
+
+    for (GLuint y = 0; y < SEGMENTS; ++y)
+        for (GLuint x = 0; x < SEGMENTS; ++x)
+        {
+            GLuint current = y * (SEGMENTS + 1) + x, above = current + SEGMENTS + 1;
+            mesh.indices.insert(mesh.indices.end(), {current, above, current + 1, current + 1, above, above + 1});
+        }
+
+    return mesh;
+}
+
+template<typename Surface, size_t... LEVELS>
+std::array<PrimitiveMesh, LOD_COUNT> generateLodChain(std::index_sequence<LEVELS...>)
+{
+    return {generateSurface<Surface, LOD_SEGMENTS[LEVELS]>()...};
+}
+
+template<typename Surface>
+std::array<PrimitiveMesh, LOD_COUNT> generateLodChain()
+{
+    return generateLodChain<Surface>(std::make_index_sequence<LOD_COUNT>());
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <GL/glew.h>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define PROFILER_USE_RDTSC
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+struct ProfileEvent
+{
+    const GLchar* name;
+    std::uint64_t start, end;
+};
+
+class Profiler
+{
+public:
+    static constexpr std::size_t BUFFER_CAPACITY = 1 << 16;
+
+    struct ThreadBuffer
+    {
+        std::array<ProfileEvent, BUFFER_CAPACITY> events;
+        std::atomic<std::uint64_t> head = 0;
+        std::thread::id threadId;
+        GLuint index = 0;
+    };
+
+    static void setEnabled(bool value);
+    static void setGpuMarkers(bool value);
+    [[nodiscard]] static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+    [[nodiscard]] static bool gpuMarkersEnabled() { return gpuMarkers.load(std::memory_order_relaxed); }
+
+    static std::uint64_t now()
+    {
+        #ifdef PROFILER_USE_RDTSC
+        return __rdtsc();
+        #else
+        return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+        #endif
+    }
+
+    static void record(const GLchar* name, std::uint64_t start, std::uint64_t end)
+    {
+        ThreadBuffer &buffer = threadBuffer();
+        std::uint64_t head = buffer.head.load(std::memory_order_relaxed);
+
+        buffer.events[head % BUFFER_CAPACITY] = {name, start, end};
+        buffer.head.store(head + 1, std::memory_order_release);
+    }
+
+    static bool isMainThread() { return std::this_thread::get_id() == mainThread; }
+    static bool writeTrace(const std::string &path);
+
+private:
+    static inline std::atomic<bool> enabled = false, gpuMarkers = false;
+    static inline std::thread::id mainThread = std::this_thread::get_id();
+    static inline std::uint64_t epochTicks = now();
+    static inline std::chrono::steady_clock::time_point epochTime = std::chrono::steady_clock::now();
+
+    static inline std::mutex registryMutex;
+    static inline std::vector<std::unique_ptr<ThreadBuffer>> registry;
+
+    static ThreadBuffer &threadBuffer()
+    {
+        thread_local ThreadBuffer* buffer = registerThread();
+        return *buffer;
+    }
+
+    static ThreadBuffer* registerThread();
+};
+
+class ProfileScope
+{
+public:
+    explicit ProfileScope(const GLchar* name)
+    {
+        if (!Profiler::isEnabled()) return;
+
+        this->name = name;
+        if (Profiler::gpuMarkersEnabled() && Profiler::isMainThread())
+        {
+            glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, 0, -1, name);
+            gpuMarker = true;
+        }
+        start = Profiler::now();
+    }
+
+    ProfileScope(const ProfileScope &) = delete;
+    ProfileScope &operator=(const ProfileScope &) = delete;
+
+    ~ProfileScope()
+    {
+        if (!name) return;
+
+        Profiler::record(name, start, Profiler::now());
+        if (gpuMarker) glPopDebugGroup();
+    }
+
+private:
+    const GLchar* name = nullptr;
+    std::uint64_t start = 0;
+    bool gpuMarker = false;
+};
+
+#ifdef DISABLE_PROFILER
+#define PROFILE_SCOPE(name)
+#else
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#endif
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "objects.h"
+#include "texture.h"
+#include "timer.h"
+
+class Material
+{
+public:
+    explicit Material(std::vector<std::shared_ptr<Texture>> textures);
+    Material(const Material &) = delete;
+    Material &operator=(const Material &) = delete;
+
+    void apply(const Shader &shader, Uniform<bool> hasTexture) const;
+
+    const GLuint id;
+    std::vector<std::shared_ptr<Texture>> textures;
+};
+
+class IndirectRenderer;
+
+struct DrawPacket
+{
+    std::uint64_t key = 0;
+    Object* object = nullptr;
+    const Material* material = nullptr;
+};
+
+struct StateChanges
+{
+    GLuint programs = 0, materials = 0, vertexArrays = 0;
+
+    [[nodiscard]] GLuint total() const { return programs + materials + vertexArrays; }
+};
+
+class RenderQueue
+{
+public:
+    static constexpr GLuint PASS_BITS = 3, PROGRAM_BITS = 12, MATERIAL_BITS = 12, VERTEX_ARRAY_BITS = 12,
+            DEPTH_BITS = 24;
+
+    static std::uint64_t makeKey(GpuPass pass, bool translucent, GLuint program, GLuint material, GLuint vertexArray,
+                                 GLfloat depth);
+
+    void push(GpuPass pass, Object &object, const Material &material, GLfloat depth, bool translucent = false);
+    void sort();
+    void submit(GpuTimer* timer = nullptr);
+    void clear();
+    void setIndirect(const Shader &shader, IndirectRenderer* renderer);
+
+    [[nodiscard]] size_t size() const { return packets.size(); }
+    [[nodiscard]] const StateChanges &unsortedChanges() const { return unsorted; }
+    [[nodiscard]] const StateChanges &submittedChanges() const { return submitted; }
+    [[nodiscard]] GLuint indirectBatches() const { return batches; }
+    [[nodiscard]] GLuint indirectDraws() const { return batchedDraws; }
+
+private:
+    std::vector<DrawPacket> packets, scratch;
+    StateChanges unsorted, submitted;
+    std::unordered_map<const Shader*, IndirectRenderer*> indirect;
+    std::unordered_map<const Shader*, Uniform<bool>> hasTextureUniforms;
+    GLuint batches = 0, batchedDraws = 0;
+
+    Uniform<bool> hasTextureUniform(const Shader &shader);
+    static bool batchable(const DrawPacket &first, const DrawPacket &packet);
+
+    static StateChanges countChanges(std::span<const DrawPacket> packets);
+    static void radixSort(std::vector<DrawPacket> &packets, std::vector<DrawPacket> &scratch);
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "shader.h"
+#include "texture.h"
+#include "model.h"
+
+class ResourceManager
+{
+public:
+    std::shared_ptr<Shader> getShader(const std::string &vertexPath, const std::string &fragmentPath);
+    std::shared_ptr<Shader> getComputeShader(const std::string &computePath);
+    std::shared_ptr<Texture> getTexture(const std::string &path, const std::string &type);
+    std::shared_ptr<Texture> getTextureAsync(const std::string &path, const std::string &type);
+    std::shared_ptr<Model> getModel(const std::string &path, const std::shared_ptr<Shader> &shader,
+                                    GLuint importFlags = DEFAULT_IMPORT_FLAGS);
+
+    void update();
+    void waitForTextures();
+    [[nodiscard]] size_t pendingTextures() const { return textureLoader.pendingCount(); }
+    [[nodiscard]] size_t textureMemory() const;
+
+    void purgeUnused();
+    void clear();
+
+private:
+    TextureLoader textureLoader;
+
+    std::unordered_map<std::string, std::shared_ptr<Shader>> shaders;
+    std::unordered_map<std::string, std::shared_ptr<Texture>> textures;
+    std::unordered_map<std::string, std::shared_ptr<Model>> models;
+
+    template<typename T, typename Loader>
+    static std::shared_ptr<T> getOrLoad(std::unordered_map<std::string, std::shared_ptr<T>> &cache,
+                                        const std::string &key, Loader loader)
+    {
+        auto it = cache.find(key);
+        if (it != cache.end()) return it->second;
+
+        return cache.emplace(key, loader()).first->second;
+    }
+
+    template<typename T>
+    static void purge(std::unordered_map<std::string, std::shared_ptr<T>> &cache)
+    {
+        std::erase_if(cache, [](const auto &entry) { return entry.second.use_count() == 1; });
+    }
+};
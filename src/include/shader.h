@@ -1,7 +1,12 @@
 #pragma once
 
+#include <algorithm>
+#include <initializer_list>
 #include <iostream>
+#include <span>
 #include <string>
+#include <string_view>
+#include <vector>
 #include <fstream>
 #include <sstream>
 
@@ -11,22 +16,105 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include "buffers.h"
+
+template<typename T>
+struct Uniform
+{
+    GLint index = -1;
+
+    [[nodiscard]] bool valid() const { return index >= 0; }
+};
+
+struct UniformInfo
+{
+    std::string name;
+    GLint location, size;
+    GLenum type;
+};
+
 class Shader
 {
 public:
-    GLuint ID;
+    GLuint ID = 0;
 
     Shader(const GLchar* vertexPath, const GLchar* fragmentPath);
+    explicit Shader(const GLchar* computePath);
+    Shader(const Shader &) = delete;
+    Shader &operator=(const Shader &) = delete;
     ~Shader();
 
     void use() const;
-    void setMatrices(glm::mat4 view, glm::mat4 projection) const;
-
-    void setBool(const std::string &name, bool value) const;
-    void setInt(const std::string &name, GLint value) const;
-    void setFloat(const std::string &name, GLfloat value) const;
-    void setVec2(const std::string &name, glm::vec2 value) const;
-    void setVec3(const std::string &name, glm::vec3 value) const;
-    void setVec4(const std::string &name, glm::vec4 value) const;
-    void setMat4(const std::string &name, glm::mat4 value) const;
+    void bindUniformBlock(const GLchar* name, GLuint binding) const;
+
+    template<typename T>
+    [[nodiscard]] Uniform<T> getUniform(std::string_view name) const { return {findUniform(name)}; }
+    [[nodiscard]] const std::vector<UniformInfo> &getUniforms() const { return uniforms; }
+
+    void set(Uniform<bool> uniform, bool value) const
+    {
+        if (uniform.valid()) glUniform1i(uniforms[uniform.index].location, static_cast<GLint>(value));
+    }
+
+    void set(Uniform<GLint> uniform, GLint value) const
+    {
+        if (uniform.valid()) glUniform1i(uniforms[uniform.index].location, value);
+    }
+
+    void set(Uniform<GLuint> uniform, GLuint value) const
+    {
+        if (uniform.valid()) glUniform1ui(uniforms[uniform.index].location, value);
+    }
+
+    void set(Uniform<GLfloat> uniform, GLfloat value) const
+    {
+        if (uniform.valid()) glUniform1f(uniforms[uniform.index].location, value);
+    }
+
+    void set(Uniform<glm::vec2> uniform, const glm::vec2 &value) const
+    {
+        if (uniform.valid()) glUniform2fv(uniforms[uniform.index].location, 1, glm::value_ptr(value));
+    }
+
+    void set(Uniform<glm::vec3> uniform, const glm::vec3 &value) const
+    {
+        if (uniform.valid()) glUniform3fv(uniforms[uniform.index].location, 1, glm::value_ptr(value));
+    }
+
+    void set(Uniform<glm::vec4> uniform, const glm::vec4 &value) const
+    {
+        if (uniform.valid()) glUniform4fv(uniforms[uniform.index].location, 1, glm::value_ptr(value));
+    }
+
+    void set(Uniform<glm::vec4> uniform, std::span<const glm::vec4> values) const
+    {
+        if (uniform.valid() && !values.empty())
+        {
+            auto count = std::min(static_cast<GLint>(values.size()), uniforms[uniform.index].size);
+            glUniform4fv(uniforms[uniform.index].location, count, glm::value_ptr(values[0]));
+        }
+    }
+
+    void set(Uniform<glm::mat4> uniform, const glm::mat4 &value) const
+    {
+        if (uniform.valid()) glUniformMatrix4fv(uniforms[uniform.index].location, 1, GL_FALSE, glm::value_ptr(value));
+    }
+
+    void setBool(std::string_view name, bool value) const;
+    void setInt(std::string_view name, GLint value) const;
+    void setFloat(std::string_view name, GLfloat value) const;
+    void setVec2(std::string_view name, glm::vec2 value) const;
+    void setVec3(std::string_view name, glm::vec3 value) const;
+    void setVec4(std::string_view name, glm::vec4 value) const;
+    void setMat4(std::string_view name, glm::mat4 value) const;
+
+private:
+    std::vector<UniformInfo> uniforms;
+
+    static bool readSource(const GLchar* path, const GLchar* stage, std::string &source);
+    static GLuint compile(GLenum type, const std::string &source, const GLchar* stage);
+    void link(std::initializer_list<GLuint> stages);
+    void reflectUniforms();
+    void bindUniformBlocks() const;
+    [[nodiscard]] GLint findUniform(std::string_view name) const;
 };
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <GL/glew.h>
+
+struct RenderStats
+{
+    GLuint drawCalls = 0;
+    GLuint64 triangles = 0;
+    GLuint visibleObjects = 0, culledObjects = 0;
+
+    void reset()
+    {
+        drawCalls = 0;
+        triangles = 0;
+        visibleObjects = 0;
+        culledObjects = 0;
+    }
+
+    void recordCulling(GLuint visible, GLuint culled)
+    {
+        visibleObjects += visible;
+        culledObjects += culled;
+    }
+
+    void recordDraw(GLenum mode, GLsizei count, GLsizei instances = 1)
+    {
+        ++drawCalls;
+        recordTriangles(mode, count, instances);
+    }
+
+    void recordTriangles(GLenum mode, GLsizei count, GLsizei instances = 1)
+    {
+        if (mode == GL_TRIANGLES) triangles += static_cast<GLuint64>(count / 3) * instances;
+        else if ((mode == GL_TRIANGLE_STRIP || mode == GL_TRIANGLE_FAN) && count > 2)
+            triangles += static_cast<GLuint64>(count - 2) * instances;
+    }
+};
+
+inline RenderStats renderStats;
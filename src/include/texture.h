@@ -1,16 +1,77 @@
 #pragma once
 
+#include <algorithm>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <vector>
+
 #include <stb_image.h>
+#include "blockcompression.h"
 #include "shader.h"
+#include "jobs.h"
 
 class Texture
 {
 public:
     Texture(const GLchar* file, const std::string &type);
+    Texture(const Texture &) = delete;
+    Texture &operator=(const Texture &) = delete;
     ~Texture();
 
+    static std::shared_ptr<Texture> createPlaceholder(const GLchar* file, const std::string &type);
+
     void bind(GLuint textureUnit = 0) const;
+    void upload(GLint width, GLint height, GLint numChannels, const void* pixels);
+    void uploadCompressed(const CompressedImage &image, const std::byte* data);
+    [[nodiscard]] bool isReady() const { return ready; }
+    [[nodiscard]] size_t memory() const { return bytes; }
+
+    static inline bool compression = true;
 
     GLuint id = 0;
     std::string type, path;
+
+private:
+    bool ready = false;
+    size_t bytes = 0;
+
+    Texture(std::string file, std::string type, bool placeholder);
+};
+
+struct DecodedImage
+{
+    GLint width = 0, height = 0, numChannels = 0;
+    std::unique_ptr<unsigned char, void (*)(void*)> pixels{nullptr, stbi_image_free};
+    CompressedImage compressed;
+};
+
+DecodedImage decodeImage(const std::string &file, const std::string &type);
+
+class TextureLoader
+{
+public:
+    TextureLoader() = default;
+    TextureLoader(const TextureLoader &) = delete;
+    TextureLoader &operator=(const TextureLoader &) = delete;
+
+    std::shared_ptr<Texture> load(const std::string &file, const std::string &type);
+    void update(GLuint maxUploads = 4);
+    void wait(const std::shared_ptr<Texture> &texture);
+    void waitAll();
+    void release();
+
+    [[nodiscard]] size_t pendingCount() const { return pending.size(); }
+
+private:
+    struct Request
+    {
+        std::shared_ptr<Texture> texture;
+        std::future<DecodedImage> image;
+    };
+
+    std::vector<Request> pending;
+    GLuint pixelBuffer = 0;
+
+    void upload(Request &request);
 };
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "blockcompression.h"
+
+class TextureCache
+{
+public:
+    static constexpr std::uint32_t VERSION = 1;
+    static constexpr std::array<std::uint8_t, 12> IDENTIFIER = {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D,
+                                                                0x0A, 0x1A, 0x0A};
+    static constexpr std::uint32_t VK_FORMATS[BLOCK_FORMAT_COUNT] = {131, 137, 139, 141};
+    static constexpr const GLchar* METADATA_KEY = "graphicsTest4.source";
+
+    struct Header
+    {
+        std::uint8_t identifier[12];
+        std::uint32_t vkFormat, typeSize, pixelWidth, pixelHeight, pixelDepth, layerCount, faceCount, levelCount;
+        std::uint32_t supercompressionScheme;
+        std::uint32_t dfdByteOffset, dfdByteLength, kvdByteOffset, kvdByteLength;
+        std::uint64_t sgdByteOffset, sgdByteLength;
+    };
+
+    struct LevelIndex
+    {
+        std::uint64_t byteOffset, byteLength, uncompressedByteLength;
+    };
+
+    struct Metadata
+    {
+        std::uint64_t sourceHash;
+        std::uint32_t version, format;
+    };
+
+    static_assert(sizeof(Header) == 80, "Header must match the KTX2 file layout");
+    static_assert(sizeof(LevelIndex) == 24, "LevelIndex must match the KTX2 file layout");
+
+    static std::string pathFor(const std::string &sourcePath);
+    static std::optional<CompressedImage> read(const std::string &path, std::uint64_t sourceHash, BlockFormat format);
+    static bool write(const std::string &path, std::uint64_t sourceHash, const CompressedImage &image);
+};
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include <GL/glew.h>
+
+enum GpuPass
+{
+    PASS_MESHES,
+    PASS_LIGHT,
+    PASS_TEXTURED,
+    PASS_STRESS,
+    PASS_DEPTH_PYRAMID,
+    PASS_GUI,
+    PASS_COUNT
+};
+
+constexpr const GLchar* GPU_PASS_NAMES[PASS_COUNT] = {"Meshes", "Light Cube", "Textured Objects", "Stress Cubes",
+                                                       "Depth Pyramid", "ImGui"};
+
+struct GpuFrameTimings
+{
+    GLuint64 frame = 0;
+    GLdouble total = 0.0;
+    std::array<GLdouble, PASS_COUNT> passes = {};
+};
+
+class GpuTimer
+{
+public:
+    static constexpr GLuint LATENCY = 4;
+
+    GpuTimer();
+    GpuTimer(const GpuTimer &) = delete;
+    GpuTimer &operator=(const GpuTimer &) = delete;
+    ~GpuTimer();
+
+    void beginFrame();
+    void endFrame();
+    void begin(GpuPass pass);
+    void end(GpuPass pass);
+    void flush();
+    void record(bool enabled) { recording = enabled; }
+
+    [[nodiscard]] GLuint64 frameNumber() const { return frameIndex; }
+    [[nodiscard]] const GpuFrameTimings &latest() const { return latestTimings; }
+    [[nodiscard]] GLuint64 droppedFrames() const { return dropped; }
+    std::vector<GpuFrameTimings> takeCompleted();
+
+    class Scope
+    {
+    public:
+        Scope(GpuTimer &timer, GpuPass pass) : timer(timer), pass(pass) { timer.begin(pass); }
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+        ~Scope() { timer.end(pass); }
+
+    private:
+        GpuTimer &timer;
+        GpuPass pass;
+    };
+
+private:
+    struct FrameQueries
+    {
+        std::array<GLuint, (PASS_COUNT + 1) * 2> queries = {};
+        std::array<bool, PASS_COUNT> issued = {};
+        GLuint64 frame = 0;
+        bool pending = false;
+    };
+
+    std::array<FrameQueries, LATENCY> ring;
+    GLuint64 frameIndex = 0, dropped = 0;
+    bool recording = false;
+    GpuFrameTimings latestTimings;
+    std::vector<GpuFrameTimings> completed;
+
+    FrameQueries &current() { return ring[frameIndex % LATENCY]; }
+    bool resolve(FrameQueries &frame, bool wait);
+};
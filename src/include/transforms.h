@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "jobs.h"
+
+glm::mat4 composeTransform(const glm::vec3 &position, const glm::vec3 &rotation, const glm::vec3 &scale);
+void multiplyTransforms(const glm::mat4 &parent, const glm::mat4 &local, glm::mat4 &result);
+
+class TransformHierarchy
+{
+public:
+    using Handle = GLuint;
+    static constexpr Handle INVALID_HANDLE = std::numeric_limits<Handle>::max();
+    static constexpr GLuint PARALLEL_THRESHOLD = 4096;
+
+    TransformHierarchy() = default;
+    TransformHierarchy(const TransformHierarchy &) = delete;
+    TransformHierarchy &operator=(const TransformHierarchy &) = delete;
+    TransformHierarchy(TransformHierarchy &&) = default;
+    TransformHierarchy &operator=(TransformHierarchy &&) = default;
+
+    Handle create(Handle parent = INVALID_HANDLE);
+    void reserve(size_t count);
+    void setParent(Handle node, Handle parent);
+    void setLocal(Handle node, const glm::vec3 &position, const glm::vec3 &rotation, const glm::vec3 &scale);
+    void update(JobSystem* jobs = nullptr);
+
+    [[nodiscard]] const glm::mat4 &world(Handle node) const { return worlds[slots[node]]; }
+    [[nodiscard]] Handle parent(Handle node) const { return parents[node]; }
+    [[nodiscard]] size_t size() const { return handles.size(); }
+    [[nodiscard]] GLuint lastUpdateCount() const { return updatedNodes; }
+
+private:
+    std::vector<Handle> parents;
+    std::vector<std::vector<Handle>> children;
+    std::vector<GLuint> slots;
+
+    std::vector<Handle> handles;
+    std::vector<GLuint> parentSlots, subtreeEnds;
+    std::vector<glm::vec3> positions, rotations, scales;
+    std::vector<glm::mat4> locals, worlds;
+    std::vector<std::uint8_t> dirty;
+
+    bool structureChanged = false;
+    GLuint updatedNodes = 0;
+
+    void rebuildOrder();
+    void updateRange(GLuint first, GLuint last, JobSystem* jobs);
+};
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+struct Vertex
+{
+    glm::vec3 position, normal, color;
+    glm::vec2 texCoords;
+};
+
+static_assert(sizeof(Vertex) == 11 * sizeof(GLfloat), "Vertex must be tightly packed for direct uploads");
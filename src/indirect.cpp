@@ -0,0 +1,135 @@
+#include "include/indirect.h"
+#include "include/glstate.h"
+#include "include/profiler.h"
+
+#include <algorithm>
+#include <numeric>
+
+IndirectRenderer::IndirectRenderer(std::shared_ptr<Shader> shader, RingBuffer* ring)
+        : shader(std::move(shader)), ring(ring)
+{
+    glGenBuffers(1, &commandBuffer);
+    glGenBuffers(1, &drawBuffer);
+    glGenBuffers(1, &drawIdBuffer);
+}
+
+IndirectRenderer::~IndirectRenderer()
+{
+    for (GLuint buffer: {commandBuffer, drawBuffer, drawIdBuffer}) GLState::forgetBuffer(buffer);
+
+    glDeleteBuffers(1, &commandBuffer);
+    glDeleteBuffers(1, &drawBuffer);
+    glDeleteBuffers(1, &drawIdBuffer);
+}
+
+bool IndirectRenderer::supported() { return GLEW_VERSION_4_3; }
+
+void IndirectRenderer::draw(std::span<const DrawPacket> packets, JobSystem* jobs)
+{
+    PROFILE_SCOPE("IndirectRenderer::draw");
+
+    if (packets.empty()) return;
+
+    auto count = static_cast<GLuint>(packets.size());
+    auto drawBytes = static_cast<GLsizeiptr>(count * sizeof(IndirectDrawData));
+    auto commandBytes = static_cast<GLsizeiptr>(count * sizeof(DrawElementsIndirectCommand));
+
+    RingBuffer::Allocation drawAllocation, commandAllocation;
+    if (ring)
+    {
+        drawAllocation = ring->allocate(GL_SHADER_STORAGE_BUFFER, drawBytes);
+        if (drawAllocation.valid()) commandAllocation = ring->allocate(GL_DRAW_INDIRECT_BUFFER, commandBytes);
+    }
+
+    bool streamed = commandAllocation.valid();
+    if (!streamed)
+    {
+        draws.resize(count);
+        commands.resize(count);
+    }
+
+    auto* drawData = streamed ? reinterpret_cast<IndirectDrawData*>(drawAllocation.data) : draws.data();
+    auto* commandData = streamed ? reinterpret_cast<DrawElementsIndirectCommand*>(commandAllocation.data)
+                                 : commands.data();
+
+    auto fill = [&](size_t first, size_t last)
+    {
+        for (size_t i = first; i < last; ++i)
+        {
+            const Object &object = *packets[i].object;
+            const Geometry &geometry = *object.geometry();
+            const glm::mat4 &model = object.model();
+            glm::mat3 normal = glm::transpose(glm::inverse(glm::mat3(model)));
+
+            commandData[i] = {static_cast<GLuint>(geometry.count), 1, geometry.firstIndex, geometry.baseVertex,
+                              static_cast<GLuint>(i)};
+            drawData[i] = {model,
+                           {glm::vec4(normal[0], 0.0f), glm::vec4(normal[1], 0.0f), glm::vec4(normal[2], 0.0f)}};
+        }
+    };
+
+    if (jobs) jobs->parallelFor(count, fill, 1024);
+    else fill(0, count);
+
+    const Geometry &first = *packets.front().object->geometry();
+    reserveDrawIds(count);
+    attachDrawIds(first.pool);
+
+    if (streamed)
+    {
+        ring->bindRange(GL_SHADER_STORAGE_BUFFER, DRAW_STORAGE_BINDING, drawAllocation);
+        GLState::bindBuffer(GL_DRAW_INDIRECT_BUFFER, ring->ID);
+    } else
+    {
+        upload(GL_SHADER_STORAGE_BUFFER, drawBuffer, drawCapacity, draws.data(), drawBytes);
+        GLState::bindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_STORAGE_BINDING, drawBuffer);
+        upload(GL_DRAW_INDIRECT_BUFFER, commandBuffer, commandCapacity, commands.data(), commandBytes);
+    }
+
+    first.pool.bind(INSTANCE_ARRAYS_DRAW_ID);
+    glMultiDrawElementsIndirect(first.mode, GL_UNSIGNED_INT,
+                                reinterpret_cast<const void*>(streamed ? commandAllocation.offset : 0),
+                                static_cast<GLsizei>(count), 0);
+
+    GLuint64 indices = 0;
+    for (const auto &packet: packets) indices += packet.object->geometry()->count;
+    renderStats.recordDraw(first.mode, static_cast<GLsizei>(indices));
+}
+
+void IndirectRenderer::reserveDrawIds(GLuint count)
+{
+    if (count <= drawIdCapacity) return;
+
+    drawIdCapacity = std::max(count, drawIdCapacity * 2);
+    std::vector<GLuint> ids(drawIdCapacity);
+    std::iota(ids.begin(), ids.end(), 0u);
+
+    GLState::bindBuffer(GL_ARRAY_BUFFER, drawIdBuffer);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(ids.size() * sizeof(GLuint)), ids.data(), GL_STATIC_DRAW);
+}
+
+void IndirectRenderer::attachDrawIds(const GeometryPool &pool)
+{
+    if (std::ranges::find(attachedArrays, pool.VAO) != attachedArrays.end()) return;
+
+    pool.bind();
+    GLState::bindBuffer(GL_ARRAY_BUFFER, drawIdBuffer);
+    glVertexAttribIPointer(DRAW_ID_LOCATION, 1, GL_UNSIGNED_INT, sizeof(GLuint), nullptr);
+    glVertexAttribDivisor(DRAW_ID_LOCATION, 1);
+
+    attachedArrays.push_back(pool.VAO);
+}
+
+void IndirectRenderer::upload(GLenum target, GLuint buffer, GLsizeiptr &capacity, const void* data, GLsizeiptr size)
+{
+    GLState::bindBuffer(target, buffer);
+    if (size > capacity)
+    {
+        capacity = size;
+        glBufferData(target, capacity, data, GL_STREAM_DRAW);
+    } else
+    {
+        glBufferData(target, capacity, nullptr, GL_STREAM_DRAW);
+        glBufferSubData(target, 0, size, data);
+    }
+}
@@ -0,0 +1,62 @@
+#include "include/instancing.h"
+#include "include/profiler.h"
+
+InstanceBatch::InstanceBatch(std::vector<std::shared_ptr<Geometry>> geometries, std::shared_ptr<Shader> shader)
+        : geometries(std::move(geometries)), shader(std::move(shader)) {}
+
+void InstanceBatch::add(const glm::mat4 &model)
+{
+    models.push_back(model);
+    dirty = true;
+}
+
+void InstanceBatch::clear()
+{
+    models.clear();
+    dirty = true;
+}
+
+void InstanceBatch::draw()
+{
+    if (models.empty()) return;
+
+    if (dirty)
+    {
+        PROFILE_SCOPE("InstanceBatch::upload");
+
+        instances.update(models);
+        dirty = false;
+    }
+
+    for (const auto &geometry: geometries) geometry->drawInstanced(instances);
+}
+
+void InstanceRenderer::submit(Object &object)
+{
+    auto &batch = batches[{object.geometryKey(), object.shader().get()}];
+    if (!batch) batch = std::make_unique<InstanceBatch>(object.instanceGeometries(), object.shader());
+
+    batch->add(object.model());
+}
+
+void InstanceRenderer::clear()
+{
+    // Batches that received nothing since the last clear belong to geometry no longer in use.
+    std::erase_if(batches, [](const auto &entry) { return entry.second->size() == 0; });
+    for (auto &[key, batch]: batches) batch->clear();
+}
+
+void InstanceRenderer::draw()
+{
+    PROFILE_SCOPE("InstanceRenderer::draw");
+
+    for (auto &[key, batch]: batches) batch->draw();
+}
+
+size_t InstanceRenderer::instanceCount() const
+{
+    size_t count = 0;
+    for (const auto &[key, batch]: batches) count += batch->size();
+
+    return count;
+}
@@ -0,0 +1,247 @@
+#include "include/jobs.h"
+#include "include/profiler.h"
+
+namespace
+{
+    constexpr size_t NOT_A_WORKER = std::numeric_limits<size_t>::max();
+    constexpr unsigned int SPIN_ATTEMPTS = 64;
+
+    thread_local const JobSystem* currentSystem = nullptr;
+    thread_local size_t currentIndex = NOT_A_WORKER;
+}
+
+bool WorkStealingDeque::push(Job* job)
+{
+    std::int64_t b = bottom.load(std::memory_order_relaxed), t = top.load(std::memory_order_acquire);
+    if (b - t >= CAPACITY) return false;
+
+    buffer[b & (CAPACITY - 1)].store(job, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom.store(b + 1, std::memory_order_relaxed);
+
+    return true;
+}
+
+Job* WorkStealingDeque::pop()
+{
+    std::int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+    bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::int64_t t = top.load(std::memory_order_relaxed);
+
+    if (t > b)
+    {
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    Job* job = buffer[b & (CAPACITY - 1)].load(std::memory_order_relaxed);
+    if (t == b)
+    {
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            job = nullptr;
+
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    return job;
+}
+
+Job* WorkStealingDeque::steal()
+{
+    std::int64_t t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::int64_t b = bottom.load(std::memory_order_acquire);
+    if (t >= b) return nullptr;
+
+    Job* job = buffer[t & (CAPACITY - 1)].load(std::memory_order_relaxed);
+    if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) return nullptr;
+
+    return job;
+}
+
+JobSystem::JobSystem(unsigned int threads)
+{
+    currentSystem = this;
+    currentIndex = 0;
+
+    deques.reserve(threads + 1);
+    for (unsigned int i = 0; i <= threads; ++i) deques.push_back(std::make_unique<WorkStealingDeque>());
+
+    workers.reserve(threads);
+    for (unsigned int i = 0; i < threads; ++i) workers.emplace_back(&JobSystem::run, this, i + 1);
+}
+
+JobSystem::~JobSystem()
+{
+    stopping = true;
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+
+    sleepCondition.notify_all();
+    for (auto &worker: workers) worker.join();
+
+    while (Job* job = findJob(0)) execute(job);
+    if (currentSystem == this) currentSystem = nullptr;
+}
+
+JobSystem &JobSystem::get()
+{
+    static JobSystem system;
+    return system;
+}
+
+void JobSystem::submit(std::function<void()> function, JobCounter* counter)
+{
+    if (counter) counter->value.fetch_add(1, std::memory_order_relaxed);
+    schedule(new Job{std::move(function), counter});
+}
+
+void JobSystem::submitAfter(JobCounter &dependency, std::function<void()> function, JobCounter* counter)
+{
+    if (counter) counter->value.fetch_add(1, std::memory_order_relaxed);
+    auto* job = new Job{std::move(function), counter};
+
+    {
+        std::lock_guard<std::mutex> lock(dependency.mutex);
+        if (!dependency.done())
+        {
+            dependency.continuations.push_back(job);
+            return;
+        }
+    }
+
+    schedule(job);
+}
+
+void JobSystem::wait(JobCounter &counter)
+{
+    PROFILE_SCOPE("JobSystem::wait");
+
+    size_t self = currentSystem == this ? currentIndex : NOT_A_WORKER;
+    while (!counter.done())
+    {
+        if (Job* job = findJob(self)) execute(job);
+        else std::this_thread::yield();
+    }
+
+    std::lock_guard<std::mutex> lock(counter.mutex);
+}
+
+void JobSystem::runOnMainThread(std::function<void()> function)
+{
+    std::lock_guard<std::mutex> lock(mainThreadMutex);
+    mainThreadJobs.push_back(std::move(function));
+}
+
+void JobSystem::runMainThreadJobs(size_t maxJobs)
+{
+    PROFILE_SCOPE("JobSystem::runMainThreadJobs");
+
+    std::vector<std::function<void()>> jobs;
+    {
+        std::lock_guard<std::mutex> lock(mainThreadMutex);
+
+        auto count = static_cast<std::ptrdiff_t>(std::min(maxJobs, mainThreadJobs.size()));
+        jobs.assign(std::make_move_iterator(mainThreadJobs.begin()),
+                    std::make_move_iterator(mainThreadJobs.begin() + count));
+        mainThreadJobs.erase(mainThreadJobs.begin(), mainThreadJobs.begin() + count);
+    }
+
+    for (auto &job: jobs) job();
+}
+
+void JobSystem::schedule(Job* job)
+{
+    queued.fetch_add(1);
+
+    bool pushed = currentSystem == this && currentIndex < deques.size() && deques[currentIndex]->push(job);
+    if (!pushed)
+    {
+        std::lock_guard<std::mutex> lock(injectionMutex);
+        injection.push_back(job);
+    }
+
+    if (sleeping.load() > 0)
+    {
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+        }
+
+        sleepCondition.notify_one();
+    }
+}
+
+Job* JobSystem::findJob(size_t self)
+{
+    Job* job = self < deques.size() ? deques[self]->pop() : nullptr;
+
+    if (!job && queued.load(std::memory_order_relaxed) > 0)
+    {
+        std::lock_guard<std::mutex> lock(injectionMutex);
+        if (!injection.empty())
+        {
+            job = injection.back();
+            injection.pop_back();
+        }
+    }
+
+    for (size_t i = 1; !job && i <= deques.size(); ++i)
+    {
+        size_t victim = (self + i) % deques.size();
+        if (victim != self) job = deques[victim]->steal();
+    }
+
+    if (job) queued.fetch_sub(1);
+    return job;
+}
+
+void JobSystem::execute(Job* job)
+{
+    job->function();
+
+    if (JobCounter* counter = job->counter)
+    {
+        std::vector<Job*> ready;
+        {
+            std::lock_guard<std::mutex> lock(counter->mutex);
+            if (counter->value.fetch_sub(1, std::memory_order_acq_rel) == 1) ready.swap(counter->continuations);
+        }
+
+        for (Job* continuation: ready) schedule(continuation);
+    }
+
+    delete job;
+}
+
+void JobSystem::run(size_t index)
+{
+    currentSystem = this;
+    currentIndex = index;
+
+    while (true)
+    {
+        Job* job = nullptr;
+        for (unsigned int attempt = 0; !job && attempt < SPIN_ATTEMPTS; ++attempt)
+        {
+            job = findJob(index);
+            if (!job) std::this_thread::yield();
+        }
+
+        if (job)
+        {
+            execute(job);
+            continue;
+        }
+
+        if (stopping) return;
+
+        sleeping.fetch_add(1);
+        {
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            sleepCondition.wait(lock, [this] { return queued.load() > 0 || stopping; });
+        }
+        sleeping.fetch_sub(1);
+    }
+}
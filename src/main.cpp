@@ -1,4 +1,5 @@
 #define STB_IMAGE_IMPLEMENTATION
+#include <cmath>
 #include <iostream>
 
 #include <imgui/imgui.h>
@@ -11,9 +12,26 @@
 #include "include/shader.h"
 #include "include/model.h"
 #include "include/objects.h"
+#include "include/instancing.h"
+#include "include/culling.h"
+#include "include/bvh.h"
+#include "include/picking.h"
+#include "include/transforms.h"
+#include "include/renderqueue.h"
+#include "include/indirect.h"
+#include "include/gpuculling.h"
+#include "include/glstate.h"
+#include "include/jobs.h"
 #include "include/camera.h"
+#include "include/resources.h"
+#include "include/benchmark.h"
+#include "include/timer.h"
+#include "include/profiler.h"
 
 GLint WIDTH = 1366, HEIGHT = 768;
+const GLfloat STRESS_ORBIT_SPEED = 0.03f;
+const GLuint STRESS_GROUPS = 7;
+const GLsizeiptr RING_FRAME_BYTES = 4 << 20;
 
 GLdouble lastFrameTime = 0.0f;
 const GLchar* lightTypes[] = {"Point", "Directional", "Spot"};
@@ -25,6 +43,72 @@ bool enableAmbientLight = true, enableDiffuseLight = true, enableSpecularLight =
 
 ImGuiIO io;
 Camera camera;
+ResourceManager resources;
+std::unique_ptr<GpuTimer> gpuTimer;
+
+struct Options
+{
+    BenchmarkOptions bench;
+    bool profile = false, gpuMarkers = false;
+    std::string profileOutput = "profile.json";
+    GLuint stressCubes = 0;
+    bool stressPerObject = false, stressAnimate = false, indirect = true, gpuCulling = false, ringBuffer = true;
+    bool textureCompression = true;
+} options;
+
+struct StressNode
+{
+    GLuint id = 0;
+    TransformHierarchy::Handle node = TransformHierarchy::INVALID_HANDLE;
+};
+
+enum SceneObject
+{
+    OBJECT_MODEL,
+    OBJECT_LIGHT,
+    OBJECT_SPHERE,
+    OBJECT_PLANE,
+    OBJECT_COUNT
+};
+
+struct Scene
+{
+    std::shared_ptr<Shader> defaultShader, lightShader, instancedShader;
+    Uniform<bool> instancedHasTexture;
+    std::unique_ptr<RingBuffer> ring;
+    std::unique_ptr<UniformBuffer> frameBlock, lightBlock;
+    std::shared_ptr<Texture> texDiffuse, texSpecular;
+    std::shared_ptr<Model> model;
+
+    std::unique_ptr<Cube> light;
+    std::unique_ptr<Sphere> sphere;
+    std::unique_ptr<Plane> plane;
+
+    std::unique_ptr<Material> untexturedMaterial, texturedMaterial;
+    RenderQueue queue;
+    std::unique_ptr<IndirectRenderer> indirect;
+    bool indirectEnabled = false;
+
+    std::vector<std::unique_ptr<Cube>> stressCubes;
+    InstanceRenderer instances;
+    bool instanced = true;
+
+    Culler culler, stressCuller;
+    std::unique_ptr<SceneBVH> stressBvh;
+    std::vector<GLuint> stressQuery;
+    std::vector<std::uint8_t> stressResults, stressVisibility;
+    glm::vec3 stressCenter = glm::vec3(0.0f);
+    TransformHierarchy stressTransforms;
+    std::vector<TransformHierarchy::Handle> stressGroups;
+    GLfloat stressOrbit = 0.0f;
+    bool hierarchicalCulling = true, animateStress = false;
+    std::unique_ptr<GpuCuller> gpuCuller;
+    bool gpuCulling = false, occlusionCulling = true;
+
+    PickResult pick;
+    std::string pickLabel;
+    GLdouble pickTime = 0.0;
+};
 
 void debugLog(GLenum source, GLenum type, GLuint id, GLenum severity, GLint, const GLchar* message, const void*)
 {
@@ -111,7 +195,7 @@ void debugLog(GLenum source, GLenum type, GLuint id, GLenum severity, GLint, con
     std::cerr << "\nMessage: " << message << "\n\n";
 }
 
-GLFWwindow* init()
+GLFWwindow* init(bool hidden, bool modern)
 {
     if (!glfwInit())
     {
@@ -119,7 +203,7 @@ GLFWwindow* init()
         exit(EXIT_FAILURE);
     }
 
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, modern ? 4 : 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
@@ -127,7 +211,16 @@ GLFWwindow* init()
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
     #endif
 
+    if (hidden) glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
     GLFWwindow* window = glfwCreateWindow(WIDTH, HEIGHT, "Graphics Test 4", nullptr, nullptr);
+    if (!window && modern)
+    {
+        std::cerr << "OpenGL 4.3 is unavailable, falling back to 3.3" << std::endl;
+
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        window = glfwCreateWindow(WIDTH, HEIGHT, "Graphics Test 4", nullptr, nullptr);
+    }
     if (!window)
     {
         std::cerr << "Failed to create window!" << std::endl;
@@ -137,6 +230,8 @@ GLFWwindow* init()
     }
 
     glfwMakeContextCurrent(window);
+    if (hidden) glfwSwapInterval(0);
+
     glewExperimental = GL_TRUE;
     if (glewInit() != GLEW_OK)
     {
@@ -152,7 +247,7 @@ GLFWwindow* init()
     glDebugMessageCallback(debugLog, nullptr);
     #endif
 
-    glEnable(GL_DEPTH_TEST);
+    GLState::setEnabled(GL_DEPTH_TEST, true);
     glClearColor(0.4f, 0.4f, 0.4f, 1.0f);
 
     IMGUI_CHECKVERSION();
@@ -169,7 +264,7 @@ GLFWwindow* init()
         WIDTH = width;
         HEIGHT = height;
 
-        glViewport(0, 0, width, height);
+        GLState::viewport(0, 0, width, height);
     });
 
     return window;
@@ -178,7 +273,8 @@ GLFWwindow* init()
 namespace Callbacks
 {
     bool wKeyHeld = false, sKeyHeld = false, aKeyHeld = false, dKeyHeld = false, eKeyHeld = false, qKeyHeld = false,
-            lmbHeld = false;
+            lmbHeld = false, pickRequested = false;
+    GLdouble pickX = 0.0, pickY = 0.0;
 
     void keyCallback(GLFWwindow* window, GLint key, GLint scancode, GLint action, GLint mods)
     {
@@ -206,6 +302,8 @@ namespace Callbacks
         }
 
         if (key == GLFW_KEY_SPACE && action == GLFW_PRESS) camera.resetProperties();
+        if (key == GLFW_KEY_F9 && action == GLFW_PRESS) Profiler::writeTrace(options.profileOutput);
+        if (key == GLFW_KEY_F10 && action == GLFW_PRESS) Profiler::setEnabled(!Profiler::isEnabled());
     }
 
     void cursorCallback(GLFWwindow* window, GLdouble xPos, GLdouble yPos)
@@ -239,6 +337,12 @@ namespace Callbacks
 
         if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS) lmbHeld = true;
         if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_RELEASE) lmbHeld = false;
+
+        if (button == GLFW_MOUSE_BUTTON_RIGHT && action == GLFW_PRESS)
+        {
+            glfwGetCursorPos(window, &pickX, &pickY);
+            pickRequested = true;
+        }
     }
 
     void scrollCallback(GLFWwindow* window, GLdouble xOffset, GLdouble yOffset)
@@ -252,6 +356,8 @@ namespace Callbacks
 
 void handleInput(GLFWwindow* window, GLdouble deltaTime)
 {
+    PROFILE_SCOPE("handleInput");
+
     if (Callbacks::wKeyHeld) camera.processKeyboard(CameraMovement::FORWARD, deltaTime);
     if (Callbacks::sKeyHeld) camera.processKeyboard(CameraMovement::BACKWARD, deltaTime);
     if (Callbacks::aKeyHeld) camera.processKeyboard(CameraMovement::LEFT, deltaTime);
@@ -265,8 +371,10 @@ void handleInput(GLFWwindow* window, GLdouble deltaTime)
     glfwSetScrollCallback(window, Callbacks::scrollCallback);
 }
 
-void renderGUI()
+void renderGUI(Scene &scene)
 {
+    PROFILE_SCOPE("renderGUI");
+
     ImGui_ImplOpenGL3_NewFrame();
     ImGui_ImplGlfw_NewFrame();
     ImGui::NewFrame();
@@ -283,8 +391,11 @@ void renderGUI()
     ImGui::Text("E: Move Up");
     ImGui::Text("Q: Move Down");
     ImGui::Text("LMB: Rotate Camera");
+    ImGui::Text("RMB: Pick Object");
     ImGui::Text("Scroll Wheel: Zoom Camera");
     ImGui::Text("Space: Reset Camera");
+    ImGui::Text("F9: Write Profiler Trace");
+    ImGui::Text("F10: Toggle Profiler (%s)", Profiler::isEnabled() ? "On" : "Off");
     ImGui::Text("Escape: Exit");
 
     ImGui::SeparatorText("Camera Info");
@@ -330,6 +441,78 @@ void renderGUI()
 
     ImGui::SeparatorText("Info");
     ImGui::Text("FPS: %.1f", ImGui::GetIO().Framerate);
+    ImGui::Text("Frame Time: %.3f ms", 1000.0f / ImGui::GetIO().Framerate);
+    ImGui::Text("Draw Calls: %u", renderStats.drawCalls);
+    ImGui::Text("Triangles: %llu", static_cast<unsigned long long>(renderStats.triangles));
+    ImGui::Text("Visible Objects: %u (%u culled)", renderStats.visibleObjects, renderStats.culledObjects);
+    ImGui::Text("Pending Textures: %zu", resources.pendingTextures());
+    ImGui::Text("Texture Memory: %.2f MB%s", static_cast<GLdouble>(resources.textureMemory()) / (1024.0 * 1024.0),
+                Texture::compression ? " (block compressed)" : "");
+    if (scene.ring)
+    {
+        ImGui::Text("Ring Buffer: %.2f / %.2f MB, fence wait %.3f ms",
+                    static_cast<GLdouble>(scene.ring->lastFrameUsage()) / (1024.0 * 1024.0),
+                    static_cast<GLdouble>(scene.ring->frameCapacity()) / (1024.0 * 1024.0), scene.ring->lastWaitTime());
+    }
+    ImGui::Text("Entities: %zu in %zu archetypes", EntityWorld::get().size(), EntityWorld::get().archetypeCount());
+    ImGui::Text("Sphere LOD: %u (%u segments)", scene.sphere->lod(), LOD_SEGMENTS[scene.sphere->lod()]);
+    ImGui::Text("Geometry Pools:");
+    for (GLuint format = 0; format < VERTEX_FORMAT_COUNT; ++format)
+    {
+        const GeometryPool* pool = GeometryPool::find(static_cast<VertexFormat>(format));
+        if (!pool) continue;
+
+        ImGui::BulletText("%s: %u / %u vertices, %u / %u indices", VERTEX_FORMAT_NAMES[format], pool->vertices().used(),
+                          pool->vertices().capacity(), pool->indices().used(), pool->indices().capacity());
+    }
+    if (!scene.stressCubes.empty())
+    {
+        ImGui::Checkbox("Instanced Stress Cubes", &scene.instanced);
+        ImGui::Checkbox("Hierarchical Culling", &scene.hierarchicalCulling);
+        ImGui::Checkbox("Animate Stress Cubes", &scene.animateStress);
+        if (scene.gpuCuller)
+        {
+            ImGui::Checkbox("GPU Culling", &scene.gpuCulling);
+            if (scene.gpuCulling) ImGui::Checkbox("Occlusion Culling", &scene.occlusionCulling);
+            ImGui::Text("GPU Culling: %zu instances in %zu commands", scene.gpuCuller->size(),
+                        scene.gpuCuller->commandCount());
+        }
+        ImGui::Text("Stress Cubes: %zu in %zu batches", scene.stressCubes.size(), scene.instances.batchCount());
+        ImGui::Text("BVH: %zu nodes, quality %.2f, %u rebuilds%s", scene.stressBvh->nodeCount(),
+                    scene.stressBvh->quality(), scene.stressBvh->rebuildCount(),
+                    scene.stressBvh->rebuilding() ? " (rebuilding)" : "");
+        ImGui::Text("Transforms: %zu nodes, %u updated", scene.stressTransforms.size(),
+                    scene.stressTransforms.lastUpdateCount());
+    }
+    if (scene.pick.valid())
+    {
+        ImGui::Text("Picked: %s (mesh %u, triangle %u) in %.3f ms", scene.pickLabel.c_str(), scene.pick.mesh,
+                    scene.pick.hit.triangle, scene.pickTime);
+        ImGui::BulletText("Distance: %.3f, Barycentrics: (%.3f, %.3f)", scene.pick.hit.distance,
+                          scene.pick.hit.barycentrics.x, scene.pick.hit.barycentrics.y);
+        ImGui::BulletText("Position: (%.2f, %.2f, %.2f)", scene.pick.position.x, scene.pick.position.y,
+                          scene.pick.position.z);
+    } else ImGui::Text("Picked: None (%.3f ms)", scene.pickTime);
+    const StateChanges &sorted = scene.queue.submittedChanges(), &unsorted = scene.queue.unsortedChanges();
+    ImGui::Text("Render Queue: %zu packets, %u state changes (%u unsorted)", scene.queue.size(), sorted.total(),
+                unsorted.total());
+    ImGui::BulletText("Programs: %u (%u), Materials: %u (%u), VAOs: %u (%u)", sorted.programs, unsorted.programs,
+                      sorted.materials, unsorted.materials, sorted.vertexArrays, unsorted.vertexArrays);
+    if (scene.indirect)
+    {
+        ImGui::Checkbox("Multi-Draw Indirect", &scene.indirectEnabled);
+        ImGui::BulletText("Indirect: %u draws in %u calls", scene.queue.indirectDraws(), scene.queue.indirectBatches());
+    }
+    const GLStateCounters &glCalls = GLState::lastFrame();
+    ImGui::Text("GL State Calls: %u issued, %u elided", glCalls.totalIssued(), glCalls.totalElided());
+    for (GLuint call = 0; call < CALL_COUNT; ++call)
+    {
+        if (glCalls.issued[call] + glCalls.elided[call] == 0) continue;
+        ImGui::BulletText("%s: %u / %u", GL_STATE_CALL_NAMES[call], glCalls.issued[call], glCalls.elided[call]);
+    }
+    ImGui::Text("GPU Frame Time: %.3f ms", gpuTimer->latest().total);
+    for (GLuint pass = 0; pass < PASS_COUNT; ++pass)
+        ImGui::BulletText("%s: %.3f ms", GPU_PASS_NAMES[pass], gpuTimer->latest().passes[pass]);
     ImGui::Text("OpenGL Version: %s", glGetString(GL_VERSION));
     ImGui::Text("GLSL Version: %s", glGetString(GL_SHADING_LANGUAGE_VERSION));
     ImGui::Text("ImGui Version: %s", IMGUI_VERSION);
@@ -337,117 +520,440 @@ void renderGUI()
 
     ImGui::End();
     ImGui::Render();
+
+    GpuTimer::Scope timerScope(*gpuTimer, PASS_GUI);
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    GLState::invalidate();
 }
 
-void renderGraphics(glm::mat4 &view, glm::mat4 &projection)
+void loadStressScene(Scene &scene, GLuint count)
 {
-    auto setupShader = [&](Shader &shader)
-    {
-        shader.use();
-        shader.setMatrices(view, projection);
-
-        shader.setVec3("lightColor", lightColor);
-        shader.setVec3("lightPos", lightPosition);
-        shader.setVec3("lightDirection", lightRotation);
-        shader.setVec3("viewPos", camera.getPosition());
-        shader.setVec3("objectColor", lightColor);
-        shader.setInt("lightType", lightType);
-        shader.setFloat("spotLightAngle", spotLightAngle);
-        shader.setBool("enableAmbientLight", enableAmbientLight);
-        shader.setBool("enableDiffuseLight", enableDiffuseLight);
-        shader.setBool("enableSpecularLight", enableSpecularLight);
-    };
+    PROFILE_SCOPE("loadStressScene");
+
+    auto side = static_cast<GLuint>(std::ceil(std::cbrt(static_cast<GLdouble>(count))));
+    GLfloat offset = static_cast<GLfloat>(side) - 1.0f;
+    scene.stressCenter = glm::vec3(0.0f, 0.0f, -offset - 10.0f);
 
+    auto &transforms = scene.stressTransforms;
+    transforms.reserve(count + STRESS_GROUPS);
+    for (GLuint group = 0; group < STRESS_GROUPS; ++group)
     {
-        Shader defaultShader("lib/shaders/defaultVertex.glsl", "lib/shaders/defaultFragment.glsl");
-        Model model("lib/models/cube.stl", defaultShader);
+        scene.stressGroups.push_back(transforms.create());
+        transforms.setLocal(scene.stressGroups.back(), scene.stressCenter, glm::vec3(0.0f), glm::vec3(1.0f));
+    }
 
-        setupShader(defaultShader);
-        model.draw();
+    scene.stressCubes.reserve(count);
+    for (GLuint i = 0; i < count; ++i)
+    {
+        auto &cube = scene.stressCubes.emplace_back(std::make_unique<Cube>(scene.defaultShader));
+        glm::vec3 cell(static_cast<GLfloat>(i % side), static_cast<GLfloat>(i / side % side),
+                       static_cast<GLfloat>(i / (side * side)));
+
+        Transform &local = cube->transform();
+        local.position = cell * 2.0f - glm::vec3(offset, offset, 2.0f * offset + 10.0f) - scene.stressCenter;
+        local.rotation = glm::vec3(static_cast<GLfloat>(i % 360), static_cast<GLfloat>(i * 7 % 360), 0.0f);
+        local.scale = glm::vec3(0.5f);
+
+        auto node = transforms.create(scene.stressGroups[i % STRESS_GROUPS]);
+        transforms.setLocal(node, local.position, local.rotation, local.scale);
+        EntityWorld::get().add(cube->entity(), StressNode{i, node});
     }
+    transforms.update(&JobSystem::get());
+
+    std::vector<AABB> boxes;
+    boxes.reserve(count);
+    scene.stressCuller.reserve(count);
+    for (GLuint i = 0; i < count; ++i)
     {
-        Shader lightShader("lib/shaders/lightVertex.glsl", "lib/shaders/lightFragment.glsl");
-        Cube light(lightShader);
+        Object &cube = *scene.stressCubes[i];
+        cube.model() = transforms.world(EntityWorld::get().get<StressNode>(cube.entity()).node);
+        boxes.push_back(cube.worldBox());
+        scene.stressCuller.add(boxes.back());
+        if (scene.gpuCuller) scene.gpuCuller->add(*cube.geometry(), cube.model(), cube.localBounds().box);
+    }
 
-        light.position = lightPosition;
-        light.rotation = lightRotation;
-        light.scale = lightScale;
-        light.updateModel();
+    scene.stressBvh = std::make_unique<SceneBVH>(&JobSystem::get());
+    scene.stressBvh->build(boxes);
+}
 
-        lightShader.use();
-        lightShader.setMatrices(view, projection);
+void animateStressScene(Scene &scene)
+{
+    PROFILE_SCOPE("animateStressScene");
 
-        lightShader.setVec4("lightColor", lightColor);
-        light.draw();
+    scene.stressOrbit += STRESS_ORBIT_SPEED;
+    for (GLuint group = 0; group < STRESS_GROUPS; ++group)
+    {
+        glm::vec3 rotation(0.0f, scene.stressOrbit * static_cast<GLfloat>(group + 1), 0.0f);
+        scene.stressTransforms.setLocal(scene.stressGroups[group], scene.stressCenter, rotation, glm::vec3(1.0f));
     }
+    scene.stressTransforms.update(&JobSystem::get());
+
+    EntityWorld::get().parallelForEach<const StressNode, const Bounds, WorldTransform>(JobSystem::get(),
+            [&](const StressNode &stress, const Bounds &bounds, WorldTransform &world)
     {
-        Shader sphereShader("lib/shaders/defaultVertex.glsl", "lib/shaders/defaultFragment.glsl");
-        Sphere sphere(sphereShader);
+        world.model = scene.stressTransforms.world(stress.node);
+
+        AABB box = bounds.box.transformed(world.model);
+        scene.stressCuller.update(stress.id, box);
+        scene.stressBvh->setBox(stress.id, box);
+        if (scene.gpuCuller) scene.gpuCuller->update(stress.id, world.model);
+    });
+
+    scene.stressBvh->refit();
+    scene.stressVisibility.clear();
+}
+
+Scene loadScene()
+{
+    Scene scene;
 
-        sphere.position = glm::vec3(0.0f, 0.0f, -5.0f);
-        sphere.rotation = glm::vec3(0.0f, 0.0f, 0.0f);
-        sphere.scale = glm::vec3(1.0f);
-        sphere.updateModel();
+    scene.defaultShader = resources.getShader("lib/shaders/defaultVertex.glsl", "lib/shaders/defaultFragment.glsl");
+    scene.lightShader = resources.getShader("lib/shaders/lightVertex.glsl", "lib/shaders/lightFragment.glsl");
 
-        Texture texDiffuse("lib/textures/Bricks086_1K-PNG_Color.png", "diffuse");
-        texDiffuse.bind(GL_TEXTURE0);
+    scene.instancedShader = resources.getShader("lib/shaders/instancedVertex.glsl",
+                                                "lib/shaders/defaultFragment.glsl");
 
-        Texture texSpecular("lib/textures/Bricks086_1K-PNG_Roughness.png", "specular");
-        texSpecular.bind(GL_TEXTURE1);
+    scene.instancedHasTexture = scene.instancedShader->getUniform<bool>("hasTexture");
+
+    if (options.ringBuffer && RingBuffer::supported())
+    {
+        auto stressBytes = static_cast<GLsizeiptr>(sizeof(IndirectDrawData) + sizeof(DrawElementsIndirectCommand));
+        scene.ring = std::make_unique<RingBuffer>(RING_FRAME_BYTES + options.stressCubes * stressBytes);
+    }
 
-        setupShader(sphereShader);
-        sphereShader.setBool("hasTexture", true);
-        sphere.draw();
+    std::vector shaders = {scene.defaultShader, scene.instancedShader};
+    if (options.indirect && IndirectRenderer::supported())
+    {
+        scene.indirect = std::make_unique<IndirectRenderer>(
+                resources.getShader("lib/shaders/indirectVertex.glsl", "lib/shaders/defaultFragment.glsl"),
+                scene.ring.get());
+        scene.indirectEnabled = true;
+        shaders.push_back(scene.indirect->shader);
     }
+    if (options.indirect && GpuCuller::supported() && options.stressCubes > 0)
+    {
+        scene.gpuCuller = std::make_unique<GpuCuller>(
+                resources.getComputeShader("lib/shaders/cullingCompute.glsl"),
+                resources.getComputeShader("lib/shaders/depthPyramidCompute.glsl"),
+                resources.getShader("lib/shaders/culledVertex.glsl", "lib/shaders/defaultFragment.glsl"));
+        shaders.push_back(scene.gpuCuller->drawShader);
+    }
+
+    for (const auto &shader: shaders)
     {
-        Shader planeShader("lib/shaders/defaultVertex.glsl", "lib/shaders/defaultFragment.glsl");
-        Plane plane(planeShader);
+        shader->use();
+        shader->setInt("texture_diffuse1", 0);
+        shader->setInt("texture_specular1", 1);
+        shader->setBool("hasTexture", false);
+    }
+
+    scene.frameBlock = std::make_unique<UniformBuffer>(FRAME_BLOCK_BINDING, sizeof(FrameBlock), scene.ring.get());
+    scene.lightBlock = std::make_unique<UniformBuffer>(LIGHT_BLOCK_BINDING, sizeof(LightBlock), scene.ring.get());
+
+    scene.texDiffuse = resources.getTextureAsync("lib/textures/Bricks086_1K-PNG_Color.png", "diffuse");
+    scene.texSpecular = resources.getTextureAsync("lib/textures/Bricks086_1K-PNG_Roughness.png", "specular");
+
+    scene.untexturedMaterial = std::make_unique<Material>(std::vector<std::shared_ptr<Texture>>());
+    scene.texturedMaterial = std::make_unique<Material>(std::vector{scene.texDiffuse, scene.texSpecular});
+
+    scene.model = resources.getModel("lib/models/cube.stl", scene.defaultShader);
+    scene.light = std::make_unique<Cube>(scene.lightShader);
 
-        plane.position = glm::vec3(0.0f, -1.0f, 0.0f);
-        plane.rotation = glm::vec3(0.0f, 0.0f, 0.0f);
-        plane.scale = glm::vec3(10.0f);
-        plane.updateModel();
+    scene.sphere = std::make_unique<Sphere>(scene.defaultShader);
+    scene.sphere->transform() = {glm::vec3(0.0f, 0.0f, -5.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(1.0f)};
+    scene.sphere->updateModel();
 
-        Texture texDiffuse("lib/textures/Bricks086_1K-PNG_Color.png", "diffuse");
-        texDiffuse.bind(GL_TEXTURE0);
+    scene.plane = std::make_unique<Plane>(scene.defaultShader);
+    scene.plane->transform() = {glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(10.0f)};
+    scene.plane->updateModel();
 
-        Texture texSpecular("lib/textures/Bricks086_1K-PNG_Roughness.png", "specular");
-        texSpecular.bind(GL_TEXTURE1);
+    loadStressScene(scene, options.stressCubes);
+    scene.instanced = !options.stressPerObject;
+    scene.animateStress = options.stressAnimate;
+    scene.gpuCulling = options.gpuCulling && scene.gpuCuller;
 
-        setupShader(planeShader);
-        planeShader.setBool("hasTexture", true);
-        plane.draw();
+    return scene;
+}
+
+void cullScene(Scene &scene, const Frustum &frustum)
+{
+    PROFILE_SCOPE("cullScene");
+
+    const Object* objects[OBJECT_COUNT] = {scene.model.get(), scene.light.get(), scene.sphere.get(), scene.plane.get()};
+
+    scene.culler.clear();
+    for (const auto* object: objects) scene.culler.add(object->worldBox());
+    scene.culler.cull(frustum);
+    renderStats.recordCulling(scene.culler.visibleCount(), scene.culler.culledCount());
+
+    if (scene.stressCubes.empty()) return;
+
+    if (scene.animateStress) animateStressScene(scene);
+    scene.stressBvh->poll();
+    if (scene.gpuCulling) return;
+
+    if (scene.hierarchicalCulling)
+    {
+        scene.stressQuery.clear();
+        scene.stressBvh->queryFrustum(frustum, scene.stressQuery);
+
+        scene.stressResults.assign(scene.stressCubes.size(), 0);
+        for (GLuint id: scene.stressQuery) scene.stressResults[id] = 1;
+
+        auto visible = static_cast<GLuint>(scene.stressQuery.size());
+        renderStats.recordCulling(visible, static_cast<GLuint>(scene.stressCubes.size()) - visible);
+    } else
+    {
+        scene.stressCuller.cull(frustum, &JobSystem::get());
+        renderStats.recordCulling(scene.stressCuller.visibleCount(), scene.stressCuller.culledCount());
+
+        auto results = scene.stressCuller.results();
+        scene.stressResults.assign(results.begin(), results.end());
     }
+
+    if (scene.stressResults == scene.stressVisibility) return;
+
+    scene.stressVisibility = scene.stressResults;
+    scene.instances.clear();
+    for (size_t i = 0; i < scene.stressCubes.size(); ++i)
+        if (scene.stressVisibility[i]) scene.instances.submit(*scene.stressCubes[i]);
 }
 
-int main()
+void pickScene(Scene &scene, const Ray &ray)
 {
-    auto window = init();
+    PROFILE_SCOPE("pickScene");
 
-    #ifndef NDEBUG
-    ImGui::GetIO().IniFilename = nullptr;
-    #endif
+    GLdouble start = glfwGetTime();
+    const Object* objects[OBJECT_COUNT] = {scene.model.get(), scene.light.get(), scene.sphere.get(), scene.plane.get()};
+    const GLchar* names[OBJECT_COUNT] = {"Model", "Light", "Sphere", "Plane"};
 
-    while (!glfwWindowShouldClose(window))
+    scene.pick = {};
+    for (GLuint i = 0; i < OBJECT_COUNT; ++i)
+        if (objects[i]->raycast(ray, scene.pick)) scene.pickLabel = names[i];
+
+    if (!scene.stressCubes.empty())
+    {
+        Ray stressRay = ray;
+        stressRay.maxDistance = std::min(ray.maxDistance, scene.pick.hit.distance);
+
+        RayHit hit;
+        bool found = scene.stressBvh->raycast(stressRay, hit, [&](GLuint id, const Ray &, GLfloat &distance)
+        {
+            if (!scene.stressCubes[id]->raycast(ray, scene.pick)) return false;
+
+            distance = scene.pick.hit.distance;
+            return true;
+        });
+
+        if (found) scene.pickLabel = "Stress Cube " + std::to_string(hit.id);
+    }
+
+    scene.pickTime = (glfwGetTime() - start) * 1000.0;
+}
+
+void renderGraphics(Scene &scene, glm::mat4 &view, glm::mat4 &projection)
+{
+    PROFILE_SCOPE("renderGraphics");
+
+    scene.frameBlock->update(FrameBlock{
+            .view = view,
+            .projection = projection,
+            .viewPos = glm::vec4(camera.getPosition(), 1.0f),
+    });
+    scene.lightBlock->update(LightBlock{
+            .lightPos = glm::vec4(lightPosition, 1.0f),
+            .lightDirection = glm::vec4(lightRotation, 0.0f),
+            .lightColor = lightColor,
+            .lightType = lightType,
+            .spotLightAngle = spotLightAngle,
+            .enableAmbientLight = enableAmbientLight,
+            .enableDiffuseLight = enableDiffuseLight,
+            .enableSpecularLight = enableSpecularLight,
+            .padding = {},
+    });
+
+    scene.light->transform() = {lightPosition, lightRotation, lightScale};
+    scene.light->updateModel();
+
+    Frustum frustum = Frustum::fromMatrix(projection * view);
+    cullScene(scene, frustum);
+
+    GLfloat projectionScale = static_cast<GLfloat>(HEIGHT) / (2.0f * std::tan(glm::radians(camera.fov) / 2.0f));
+    selectLods(EntityWorld::get(), camera.getPosition(), projectionScale, &JobSystem::get());
+
+    glm::vec3 eye = camera.getPosition();
+    auto push = [&](GpuPass pass, Object &object, const Material &material)
+    {
+        scene.queue.push(pass, object, material, glm::length(object.worldSphere().center - eye) / camera.far);
+    };
+
+    scene.queue.clear();
+    if (scene.culler.visible(OBJECT_MODEL)) push(PASS_MESHES, *scene.model, *scene.untexturedMaterial);
+    if (scene.culler.visible(OBJECT_LIGHT)) push(PASS_LIGHT, *scene.light, *scene.untexturedMaterial);
+    if (scene.culler.visible(OBJECT_SPHERE)) push(PASS_TEXTURED, *scene.sphere, *scene.texturedMaterial);
+    if (scene.culler.visible(OBJECT_PLANE)) push(PASS_TEXTURED, *scene.plane, *scene.texturedMaterial);
+    if (!scene.instanced && !scene.gpuCulling)
+    {
+        for (size_t i = 0; i < scene.stressCubes.size(); ++i)
+            if (scene.stressVisibility[i]) push(PASS_STRESS, *scene.stressCubes[i], *scene.untexturedMaterial);
+    }
+
+    scene.queue.setIndirect(*scene.defaultShader, scene.indirectEnabled ? scene.indirect.get() : nullptr);
+    scene.queue.sort();
+    scene.queue.submit(gpuTimer.get());
+
+    if (scene.gpuCulling)
+    {
+        {
+            GpuTimer::Scope timerScope(*gpuTimer, PASS_STRESS);
+
+            scene.gpuCuller->cull(frustum, scene.occlusionCulling);
+            scene.gpuCuller->draw();
+        }
+
+        if (scene.occlusionCulling)
+        {
+            GpuTimer::Scope timerScope(*gpuTimer, PASS_DEPTH_PYRAMID);
+            scene.gpuCuller->buildPyramid(projection * view, WIDTH, HEIGHT);
+        }
+    } else if (!scene.stressCubes.empty() && scene.instanced)
+    {
+        GpuTimer::Scope timerScope(*gpuTimer, PASS_STRESS);
+
+        scene.instancedShader->use();
+        scene.instancedShader->set(scene.instancedHasTexture, false);
+        scene.instances.draw();
+    }
+}
+
+void renderFrame(Scene &scene, bool gui)
+{
+    GLState::beginFrame();
+    if (scene.ring) scene.ring->beginFrame();
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    glm::mat4 view = camera.getViewMatrix();
+    glm::mat4 projection = camera.getProjectionMatrix(static_cast<GLfloat>(WIDTH) / static_cast<GLfloat>(HEIGHT),
+                                                      camera.fov);
+
+    renderGraphics(scene, view, projection);
+    if (gui) renderGUI(scene);
+    if (scene.ring) scene.ring->endFrame();
+}
+
+void runBenchmark(Scene &scene, const BenchmarkOptions &options)
+{
+    resources.waitForTextures();
+    Benchmark benchmark(WIDTH, HEIGHT, options.frames, *gpuTimer);
+
+    while (!benchmark.finished())
     {
         glfwPollEvents();
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        JobSystem::get().runMainThreadJobs();
 
-        glm::mat4 view = camera.getViewMatrix();
-        glm::mat4 projection = camera.getProjectionMatrix(static_cast<GLfloat>(WIDTH) / static_cast<GLfloat>(HEIGHT),
-                                                          camera.fov);
+        benchmark.beginFrame();
+        renderFrame(scene, options.gui);
+        benchmark.endFrame();
+    }
+
+    benchmark.writeReport(options.output);
+}
+
+void runInteractive(GLFWwindow* window, Scene &scene)
+{
+    while (!glfwWindowShouldClose(window))
+    {
+        glfwPollEvents();
+        renderStats.reset();
+        resources.update();
+        JobSystem::get().runMainThreadJobs();
 
         GLdouble currentFrameTime = glfwGetTime();
         GLdouble deltaTime = currentFrameTime - lastFrameTime;
         lastFrameTime = currentFrameTime;
 
         handleInput(window, deltaTime);
-        renderGraphics(view, projection);
-        renderGUI();
+
+        if (Callbacks::pickRequested)
+        {
+            GLint windowWidth, windowHeight;
+            glfwGetWindowSize(window, &windowWidth, &windowHeight);
+
+            pickScene(scene, camera.getScreenRay(static_cast<GLfloat>(Callbacks::pickX),
+                                                 static_cast<GLfloat>(Callbacks::pickY),
+                                                 static_cast<GLfloat>(windowWidth),
+                                                 static_cast<GLfloat>(windowHeight)));
+            Callbacks::pickRequested = false;
+        }
+
+        gpuTimer->beginFrame();
+        renderFrame(scene, true);
+        gpuTimer->endFrame();
 
         glfwSwapBuffers(window);
     }
+}
+
+Options parseArguments(GLint argc, GLchar* argv[])
+{
+    Options result;
+
+    for (GLint i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+
+        if (argument == "--bench" && i + 1 < argc) result.bench.frames = static_cast<GLuint>(std::stoul(argv[++i]));
+        else if (argument == "--bench-gui") result.bench.gui = true;
+        else if (argument == "--bench-output" && i + 1 < argc) result.bench.output = argv[++i];
+        else if (argument == "--profile") result.profile = true;
+        else if (argument == "--profile-output" && i + 1 < argc) result.profileOutput = argv[++i];
+        else if (argument == "--profile-gpu-markers") result.gpuMarkers = true;
+        else if (argument == "--stress" && i + 1 < argc)
+            result.stressCubes = static_cast<GLuint>(std::stoul(argv[++i]));
+        else if (argument == "--stress-per-object") result.stressPerObject = true;
+        else if (argument == "--stress-animate") result.stressAnimate = true;
+        else if (argument == "--no-indirect") result.indirect = false;
+        else if (argument == "--gpu-culling") result.gpuCulling = true;
+        else if (argument == "--no-ring-buffer") result.ringBuffer = false;
+        else if (argument == "--no-texture-compression") result.textureCompression = false;
+        else std::cerr << "Ignoring unknown argument \"" << argument << "\"" << std::endl;
+    }
+
+    return result;
+}
+
+int main(int argc, char* argv[])
+{
+    options = parseArguments(argc, argv);
+    JobSystem::get();
+    EntityWorld::get();
+    const BenchmarkOptions &benchOptions = options.bench;
+    if (benchOptions.enabled())
+    {
+        WIDTH = BENCH_WIDTH;
+        HEIGHT = BENCH_HEIGHT;
+    }
+
+    auto window = init(benchOptions.enabled(), options.indirect);
+    Texture::compression = options.textureCompression;
+    Profiler::setEnabled(options.profile);
+    Profiler::setGpuMarkers(options.gpuMarkers);
+
+    #ifndef NDEBUG
+    ImGui::GetIO().IniFilename = nullptr;
+    #endif
+
+    Scene scene = loadScene();
+    gpuTimer = std::make_unique<GpuTimer>();
+
+    if (benchOptions.enabled()) runBenchmark(scene, benchOptions);
+    else runInteractive(window, scene);
+
+    if (options.profile) Profiler::writeTrace(options.profileOutput);
+
+    scene = {};
+    gpuTimer.reset();
+    resources.clear();
 
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
@@ -0,0 +1,286 @@
+#include "include/meshcache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include "include/profiler.h"
+
+void MeshData::computeBounds()
+{
+    if (vertices.empty()) return;
+
+    boundsMin = boundsMax = vertices.front().position;
+    for (const auto &vertex: vertices)
+    {
+        boundsMin = glm::min(boundsMin, vertex.position);
+        boundsMax = glm::max(boundsMax, vertex.position);
+    }
+}
+
+MappedFile::MappedFile(const std::string &path)
+{
+    #ifdef _WIN32
+    file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                       nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        file = nullptr;
+        return;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) return;
+
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) return;
+
+    data = static_cast<const std::uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    if (data) length = static_cast<std::size_t>(fileSize.QuadPart);
+    #else
+    GLint descriptor = open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) return;
+
+    struct stat status = {};
+    if (fstat(descriptor, &status) == 0 && status.st_size > 0)
+    {
+        void* address = mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if (address != MAP_FAILED)
+        {
+            data = static_cast<const std::uint8_t*>(address);
+            length = static_cast<std::size_t>(status.st_size);
+        }
+    }
+
+    close(descriptor);
+    #endif
+}
+
+MappedFile::~MappedFile()
+{
+    #ifdef _WIN32
+    if (data) UnmapViewOfFile(data);
+    if (mapping) CloseHandle(mapping);
+    if (file) CloseHandle(file);
+    #else
+    if (data) munmap(const_cast<std::uint8_t*>(data), length);
+    #endif
+}
+
+MeshCache::MeshCache(const std::string &path) : file(path) {}
+
+bool MeshCache::matches(std::uint64_t sourceHash, GLuint importFlags) const
+{
+    if (!file.isOpen() || file.size() < sizeof(Header)) return false;
+
+    const Header* cacheHeader = header();
+    if (cacheHeader->magic != MAGIC || cacheHeader->version != VERSION || cacheHeader->vertexSize != sizeof(Vertex) ||
+        cacheHeader->sourceHash != sourceHash || cacheHeader->importFlags != importFlags)
+        return false;
+
+    std::size_t tableSize = sizeof(Header) + cacheHeader->meshCount * sizeof(Entry) +
+                            cacheHeader->textureCount * sizeof(TextureEntry);
+    if (file.size() < tableSize) return false;
+
+    for (std::uint32_t i = 0; i < cacheHeader->meshCount; ++i)
+    {
+        const Entry &meshEntry = entry(i);
+        if (meshEntry.vertexOffset + meshEntry.vertexCount * sizeof(Vertex) > file.size() ||
+            meshEntry.indexOffset + meshEntry.indexCount * sizeof(GLuint) > file.size() ||
+            meshEntry.firstTexture + meshEntry.textureCount > cacheHeader->textureCount)
+            return false;
+    }
+
+    std::size_t stringsSize = file.size() - tableSize;
+    for (std::uint32_t i = 0; i < cacheHeader->textureCount; ++i)
+    {
+        const TextureEntry &texture = textureEntries()[i];
+        if (static_cast<std::size_t>(texture.pathOffset) + texture.pathLength > stringsSize ||
+            static_cast<std::size_t>(texture.typeOffset) + texture.typeLength > stringsSize)
+            return false;
+    }
+
+    return true;
+}
+
+const MeshCache::Entry &MeshCache::entry(std::uint32_t mesh) const
+{
+    return reinterpret_cast<const Entry*>(file.bytes() + sizeof(Header))[mesh];
+}
+
+const MeshCache::TextureEntry* MeshCache::textureEntries() const
+{
+    return reinterpret_cast<const TextureEntry*>(file.bytes() + sizeof(Header) + header()->meshCount * sizeof(Entry));
+}
+
+const GLchar* MeshCache::strings() const
+{
+    return reinterpret_cast<const GLchar*>(textureEntries() + header()->textureCount);
+}
+
+std::span<const Vertex> MeshCache::vertices(std::uint32_t mesh) const
+{
+    const Entry &meshEntry = entry(mesh);
+    return {reinterpret_cast<const Vertex*>(file.bytes() + meshEntry.vertexOffset), meshEntry.vertexCount};
+}
+
+std::span<const GLuint> MeshCache::indices(std::uint32_t mesh) const
+{
+    const Entry &meshEntry = entry(mesh);
+    return {reinterpret_cast<const GLuint*>(file.bytes() + meshEntry.indexOffset), meshEntry.indexCount};
+}
+
+std::vector<TextureRef> MeshCache::textures(std::uint32_t mesh) const
+{
+    const Entry &meshEntry = entry(mesh);
+    std::vector<TextureRef> result;
+    result.reserve(meshEntry.textureCount);
+
+    for (std::uint32_t i = 0; i < meshEntry.textureCount; ++i)
+    {
+        const TextureEntry &texture = textureEntries()[meshEntry.firstTexture + i];
+        result.push_back({std::string(strings() + texture.pathOffset, texture.pathLength),
+                          std::string(strings() + texture.typeOffset, texture.typeLength)});
+    }
+
+    return result;
+}
+
+std::string MeshCache::pathFor(const std::string &sourcePath) { return sourcePath + ".meshcache"; }
+
+std::uint64_t MeshCache::hashFile(const std::string &path)
+{
+    PROFILE_SCOPE("MeshCache::hashFile");
+
+    MappedFile source(path);
+    std::uint64_t hash = 0xCBF29CE484222325ull;
+    if (!source.isOpen()) return hash;
+
+    const std::uint8_t* bytes = source.bytes();
+    for (std::size_t i = 0; i < source.size(); ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ull;
+    }
+
+    return hash;
+}
+
+bool MeshCache::write(const std::string &path, std::uint64_t sourceHash, GLuint importFlags,
+                      const std::vector<MeshData> &meshes)
+{
+    PROFILE_SCOPE("MeshCache::write");
+
+    std::vector<Entry> entries;
+    std::vector<TextureEntry> textureEntries;
+    std::string strings;
+
+    for (const auto &mesh: meshes)
+    {
+        Entry meshEntry = {};
+        meshEntry.vertexCount = static_cast<std::uint32_t>(mesh.vertices.size());
+        meshEntry.indexCount = static_cast<std::uint32_t>(mesh.indices.size());
+        meshEntry.firstTexture = static_cast<std::uint32_t>(textureEntries.size());
+        meshEntry.textureCount = static_cast<std::uint32_t>(mesh.textures.size());
+        meshEntry.materialIndex = mesh.materialIndex;
+        std::memcpy(meshEntry.boundsMin, glm::value_ptr(mesh.boundsMin), sizeof(meshEntry.boundsMin));
+        std::memcpy(meshEntry.boundsMax, glm::value_ptr(mesh.boundsMax), sizeof(meshEntry.boundsMax));
+        meshEntry.acmrBefore = mesh.optimization.before.acmr;
+        meshEntry.acmrAfter = mesh.optimization.after.acmr;
+        meshEntry.atvrBefore = mesh.optimization.before.atvr;
+        meshEntry.atvrAfter = mesh.optimization.after.atvr;
+
+        for (const auto &texture: mesh.textures)
+        {
+            TextureEntry textureEntry = {};
+            textureEntry.pathOffset = static_cast<std::uint32_t>(strings.size());
+            textureEntry.pathLength = static_cast<std::uint32_t>(texture.path.size());
+            strings += texture.path;
+
+            textureEntry.typeOffset = static_cast<std::uint32_t>(strings.size());
+            textureEntry.typeLength = static_cast<std::uint32_t>(texture.type.size());
+            strings += texture.type;
+
+            textureEntries.push_back(textureEntry);
+        }
+
+        entries.push_back(meshEntry);
+    }
+
+    auto align = [](std::uint64_t offset) { return (offset + 15) & ~static_cast<std::uint64_t>(15); };
+
+    std::uint64_t offset = align(sizeof(Header) + entries.size() * sizeof(Entry) +
+                                 textureEntries.size() * sizeof(TextureEntry) + strings.size());
+    for (size_t i = 0; i < meshes.size(); ++i)
+    {
+        entries[i].vertexOffset = offset;
+        offset = align(offset + meshes[i].vertices.size() * sizeof(Vertex));
+
+        entries[i].indexOffset = offset;
+        offset = align(offset + meshes[i].indices.size() * sizeof(GLuint));
+    }
+
+    std::string temporaryPath = path + ".tmp";
+    std::ofstream output(temporaryPath, std::ios::binary | std::ios::trunc);
+    if (!output.is_open())
+    {
+        std::cerr << "Failed to write mesh cache \"" << path << "\"" << std::endl;
+        return false;
+    }
+
+    Header cacheHeader = {MAGIC, VERSION, sourceHash, importFlags, sizeof(Vertex),
+                          static_cast<std::uint32_t>(entries.size()),
+                          static_cast<std::uint32_t>(textureEntries.size())};
+
+    auto pad = [&]
+    {
+        static const GLchar zeros[16] = {};
+        auto position = static_cast<std::uint64_t>(output.tellp());
+        output.write(zeros, static_cast<std::streamsize>(align(position) - position));
+    };
+
+    output.write(reinterpret_cast<const GLchar*>(&cacheHeader), sizeof(cacheHeader));
+    output.write(reinterpret_cast<const GLchar*>(entries.data()),
+                 static_cast<std::streamsize>(entries.size() * sizeof(Entry)));
+    output.write(reinterpret_cast<const GLchar*>(textureEntries.data()),
+                 static_cast<std::streamsize>(textureEntries.size() * sizeof(TextureEntry)));
+    output.write(strings.data(), static_cast<std::streamsize>(strings.size()));
+    pad();
+
+    for (const auto &mesh: meshes)
+    {
+        output.write(reinterpret_cast<const GLchar*>(mesh.vertices.data()),
+                     static_cast<std::streamsize>(mesh.vertices.size() * sizeof(Vertex)));
+        pad();
+        output.write(reinterpret_cast<const GLchar*>(mesh.indices.data()),
+                     static_cast<std::streamsize>(mesh.indices.size() * sizeof(GLuint)));
+        pad();
+    }
+
+    output.close();
+    std::remove(path.c_str());
+    if (!output || std::rename(temporaryPath.c_str(), path.c_str()) != 0)
+    {
+        std::cerr << "Failed to write mesh cache \"" << path << "\"" << std::endl;
+        std::remove(temporaryPath.c_str());
+
+        return false;
+    }
+
+    return true;
+}
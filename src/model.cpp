@@ -1,88 +1,151 @@
 #include "include/model.h"
+#include "include/jobs.h"
+#include "include/profiler.h"
 
-Mesh::Mesh(std::vector<Vertex> vertices, std::vector<GLuint> indices, std::vector<Texture> textures)
-        : vertices(std::move(vertices)), indices(std::move(indices)), textures(std::move(textures)), VAO(0), VBO(0),
-          EBO(0) { setupMesh(); }
+namespace
+{
+    void convertVertices(const aiMesh* mesh, std::span<Vertex> vertices)
+    {
+        PROFILE_SCOPE("convertVertices");
 
-void Mesh::draw(Shader &shader)
+        for (size_t i = 0; i < vertices.size(); ++i)
+            vertices[i].position = glm::vec3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
+
+        if (const aiVector3D* normals = mesh->mNormals)
+        {
+            for (size_t i = 0; i < vertices.size(); ++i)
+                vertices[i].normal = glm::vec3(normals[i].x, normals[i].y, normals[i].z);
+        } else for (auto &vertex: vertices) vertex.normal = glm::vec3(0.0f);
+
+        if (mesh->HasVertexColors(0))
+        {
+            const aiColor4D* colors = mesh->mColors[0];
+            for (size_t i = 0; i < vertices.size(); ++i)
+                vertices[i].color = glm::vec3(colors[i].r, colors[i].g, colors[i].b);
+        } else for (auto &vertex: vertices) vertex.color = glm::vec3(1.0f);
+
+        if (const aiVector3D* texCoords = mesh->mTextureCoords[0])
+        {
+            for (size_t i = 0; i < vertices.size(); ++i)
+                vertices[i].texCoords = glm::vec2(texCoords[i].x, texCoords[i].y);
+        } else for (auto &vertex: vertices) vertex.texCoords = glm::vec2(0.0f);
+    }
+}
+
+Mesh::Mesh(std::vector<Vertex> vertices, std::vector<GLuint> indices, std::vector<std::shared_ptr<Texture>> textures)
+        : textures(std::move(textures))
 {
+    auto data = std::make_shared<MeshData>();
+    data->vertices = std::move(vertices);
+    data->indices = std::move(indices);
+
+    this->vertices = data->vertices;
+    this->indices = data->indices;
+    source = std::move(data);
+    setupMesh(this->vertices, this->indices);
+}
+
+Mesh::Mesh(std::shared_ptr<const MeshCache> cache, std::uint32_t mesh, std::vector<std::shared_ptr<Texture>> textures)
+        : vertices(cache->vertices(mesh)), indices(cache->indices(mesh)), textures(std::move(textures)),
+          source(std::move(cache)) { setupMesh(vertices, indices); }
+
+void Mesh::resolveUniforms(const Shader &shader)
+{
+    samplerUniforms.clear();
+    samplerUniforms.reserve(textures.size());
+
     GLuint numDiffuse = 1, numSpecular = 1;
-    for (GLuint i = 0; i < textures.size(); ++i)
+    for (const auto &texture: textures)
     {
-        std::string number, name = textures[i].type;
+        std::string number, name = texture->type;
 
         if (name == "texture_diffuse") number = std::to_string(numDiffuse++);
         else if (name == "texture_specular") number = std::to_string(numSpecular++);
-        else continue;
 
-        shader.setInt(name + number, static_cast<GLint>(i));
-        textures[i].bind();
+        samplerUniforms.push_back(number.empty() ? Uniform<GLint>() : shader.getUniform<GLint>(name + number));
     }
+}
 
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, static_cast<GLint>(indices.size()), GL_UNSIGNED_INT, nullptr);
-    glBindVertexArray(0);
-    glActiveTexture(GL_TEXTURE0);
+void Mesh::draw(Shader &shader)
+{
+    bindTextures(&shader);
+    geometry->draw();
 }
 
-void Mesh::setupMesh()
+void Mesh::bindTextures(Shader* shader)
 {
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
+    for (GLuint i = 0; i < samplerUniforms.size(); ++i)
+    {
+        if (!samplerUniforms[i].valid()) continue;
 
-    std::vector<GLfloat> meshVertices;
-    meshVertices.reserve(vertices.size() * 11);
+        if (shader) shader->set(samplerUniforms[i], static_cast<GLint>(i));
+        textures[i]->bind(GL_TEXTURE0 + i);
+    }
+}
 
-    for (const auto &vertex: vertices)
-    {
-        meshVertices.push_back(vertex.position.x);
-        meshVertices.push_back(vertex.position.y);
-        meshVertices.push_back(vertex.position.z);
+const TriangleBVH &Mesh::triangles() const
+{
+    if (!geometry->triangles) geometry->triangles = std::make_shared<TriangleBVH>(vertices, indices);
 
-        meshVertices.push_back(vertex.normal.x);
-        meshVertices.push_back(vertex.normal.y);
-        meshVertices.push_back(vertex.normal.z);
+    return *geometry->triangles;
+}
 
-        meshVertices.push_back(vertex.color.x);
-        meshVertices.push_back(vertex.color.y);
-        meshVertices.push_back(vertex.color.z);
+void Mesh::setupMesh(std::span<const Vertex> vertexData, std::span<const GLuint> indexData)
+{
+    geometry = GeometryPool::get(VERTEX_FORMAT_FULL).allocate(vertexData, indexData, GL_TRIANGLES);
+}
 
-        meshVertices.push_back(vertex.texCoords.x);
-        meshVertices.push_back(vertex.texCoords.y);
-    }
+Model::Model(const GLchar* path, std::shared_ptr<Shader> shader, GLuint importFlags) : Object(std::move(shader))
+{
+    loadModel(path, importFlags);
 
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, static_cast<long>(meshVertices.size() * sizeof(GLfloat)), meshVertices.data(),
-                 GL_STATIC_DRAW);
+    auto failed = std::erase_if(meshes, [](const Mesh &mesh) { return !mesh.valid(); });
+    if (failed > 0) std::cerr << "Skipping " << failed << " meshes of \"" << path << "\" that did not fit" << std::endl;
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<long>(indices.size() * sizeof(GLuint)), indices.data(),
-                 GL_STATIC_DRAW);
+    for (auto &mesh: meshes) mesh.resolveUniforms(*this->shader());
 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), nullptr);
-    glEnableVertexAttribArray(0);
+    if (meshes.empty()) return;
 
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (void*) (3 * sizeof(GLfloat)));
-    glEnableVertexAttribArray(1);
+    AABB box = meshes.front().bounds().box;
+    for (const auto &mesh: meshes) box.expand(mesh.bounds().box);
+    world.get<Bounds>(handle) = Bounds::fromBox(box);
+}
 
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (void*) (6 * sizeof(GLfloat)));
-    glEnableVertexAttribArray(2);
+void Model::draw()
+{
+    shader()->set(modelUniform, model());
+    for (auto &mesh: meshes) mesh.draw(*shader());
+}
 
-    glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, 11 * sizeof(GLfloat), (void*) (9 * sizeof(GLfloat)));
-    glEnableVertexAttribArray(3);
+bool Model::raycast(const Ray &ray, PickResult &result) const
+{
+    bool hit = false;
+    for (GLuint i = 0; i < meshes.size(); ++i) hit |= raycastTriangles(meshes[i].triangles(), i, ray, result);
 
-    glBindVertexArray(0);
+    return hit;
 }
 
-Model::Model(const GLchar* path, Shader &shader) : Object(shader) { loadModel(path); }
-void Model::draw() { for (auto mesh: meshes) mesh.draw(shader); }
+std::vector<std::shared_ptr<Geometry>> Model::instanceGeometries() const
+{
+    std::vector<std::shared_ptr<Geometry>> result;
+    result.reserve(meshes.size());
+    for (const auto &mesh: meshes) result.push_back(mesh.sharedGeometry());
+
+    return result;
+}
 
-void Model::loadModel(const std::string &path)
+void Model::loadModel(const std::string &path, GLuint importFlags)
 {
+    PROFILE_SCOPE("Model::loadModel");
+
+    directory = path.substr(0, path.find_last_of('/'));
+
+    std::string cachePath = MeshCache::pathFor(path);
+    std::uint64_t sourceHash = MeshCache::hashFile(path);
+    if (loadCache(cachePath, sourceHash, importFlags)) return;
+
     Assimp::Importer importer;
-    const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs);
+    const aiScene* scene = importer.ReadFile(path, importFlags);
 
     if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
     {
@@ -90,89 +153,135 @@ void Model::loadModel(const std::string &path)
         return;
     }
 
-    directory = path.substr(0, path.find_last_of('/'));
-    processNode(scene->mRootNode, scene);
-}
+    std::vector<const aiMesh*> work;
+    processNode(scene->mRootNode, scene, work);
 
-void Model::processNode(aiNode* node, const aiScene* scene)
-{
-    for (GLuint i = 0; i < node->mNumMeshes; ++i)
+    std::vector<MeshData> meshData(work.size());
+    JobSystem::get().parallelFor(work.size(), [&](size_t first, size_t last)
+    {
+        for (size_t i = first; i < last; ++i) meshData[i] = processMesh(work[i], scene);
+    }, 1);
+
+    for (GLuint i = 0; i < meshData.size(); ++i)
     {
-        aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-        meshes.push_back(processMesh(mesh, scene));
+        const OptimizationReport &report = meshData[i].optimization;
+        std::cout << "Optimized mesh " << i << " of \"" << path << "\": vertices " << report.verticesBefore << " -> "
+                  << report.verticesAfter << ", ACMR " << report.before.acmr << " -> " << report.after.acmr
+                  << ", ATVR " << report.before.atvr << " -> " << report.after.atvr << std::endl;
     }
 
-    for (GLuint i = 0; i < node->mNumChildren; ++i) processNode(node->mChildren[i], scene);
+    MeshCache::write(cachePath, sourceHash, importFlags, meshData);
+
+    GLuint vertexCount = 0, indexCount = 0;
+    for (const auto &data: meshData)
+    {
+        vertexCount += static_cast<GLuint>(data.vertices.size());
+        indexCount += static_cast<GLuint>(data.indices.size());
+    }
+
+    GeometryPool::get(VERTEX_FORMAT_FULL).reserve(vertexCount, indexCount);
+    meshes.reserve(meshData.size());
+    for (auto &data: meshData)
+    {
+        auto textures = loadTextures(data.textures);
+
+        meshes.emplace_back(std::move(data.vertices), std::move(data.indices), std::move(textures));
+    }
 }
 
-Mesh Model::processMesh(aiMesh* mesh, const aiScene* scene)
+bool Model::loadCache(const std::string &cachePath, std::uint64_t sourceHash, GLuint importFlags)
 {
-    std::vector<Vertex> vertices;
-    std::vector<GLuint> indices;
-    std::vector<Texture> textures;
+    PROFILE_SCOPE("Model::loadCache");
 
-    vertices.reserve(mesh->mNumVertices);
-    for (GLuint i = 0; i < mesh->mNumVertices; ++i)
+    auto cache = std::make_shared<const MeshCache>(cachePath);
+    if (!cache->matches(sourceHash, importFlags)) return false;
+
+    GLuint vertexCount = 0, indexCount = 0;
+    for (std::uint32_t i = 0; i < cache->meshCount(); ++i)
     {
-        Vertex vertex = {};
+        vertexCount += static_cast<GLuint>(cache->vertices(i).size());
+        indexCount += static_cast<GLuint>(cache->indices(i).size());
+    }
 
-        vertex.position.x = mesh->mVertices[i].x;
-        vertex.position.y = mesh->mVertices[i].y;
-        vertex.position.z = mesh->mVertices[i].z;
+    // Meshes keep the mapping alive, so the picking BVH is later built straight from the cached data.
+    GeometryPool::get(VERTEX_FORMAT_FULL).reserve(vertexCount, indexCount);
+    meshes.reserve(cache->meshCount());
+    for (std::uint32_t i = 0; i < cache->meshCount(); ++i)
+        meshes.emplace_back(cache, i, loadTextures(cache->textures(i)));
 
-        vertex.normal.x = mesh->mNormals[i].x;
-        vertex.normal.y = mesh->mNormals[i].y;
-        vertex.normal.z = mesh->mNormals[i].z;
+    return true;
+}
 
-        if (mesh->HasVertexColors(0))
-        {
-            vertex.color.x = mesh->mColors[0][i].r;
-            vertex.color.y = mesh->mColors[0][i].g;
-            vertex.color.z = mesh->mColors[0][i].b;
-        } else vertex.color = glm::vec3(1.0f, 1.0f, 1.0f);
+void Model::processNode(const aiNode* node, const aiScene* scene, std::vector<const aiMesh*> &work)
+{
+    for (GLuint i = 0; i < node->mNumMeshes; ++i) work.push_back(scene->mMeshes[node->mMeshes[i]]);
+    for (GLuint i = 0; i < node->mNumChildren; ++i) processNode(node->mChildren[i], scene, work);
+}
 
-        if (mesh->mTextureCoords[0])
-        {
-            vertex.texCoords.x = mesh->mTextureCoords[0][i].x;
-            vertex.texCoords.y = mesh->mTextureCoords[0][i].y;
-        } else vertex.texCoords = glm::vec2(0.0f, 0.0f);
+MeshData Model::processMesh(const aiMesh* mesh, const aiScene* scene)
+{
+    PROFILE_SCOPE("Model::processMesh");
 
-        vertices.push_back(vertex);
-    }
+    MeshData data;
+    std::vector<Vertex> &vertices = data.vertices;
+    std::vector<GLuint> &indices = data.indices;
+
+    vertices.resize(mesh->mNumVertices);
+    convertVertices(mesh, vertices);
 
-    indices.reserve(mesh->mNumFaces * 3);
+    size_t indexCount = 0;
+    for (GLuint i = 0; i < mesh->mNumFaces; ++i) indexCount += mesh->mFaces[i].mNumIndices;
+
+    indices.resize(indexCount);
+    GLuint* output = indices.data();
     for (GLuint i = 0; i < mesh->mNumFaces; ++i)
     {
-        aiFace face = mesh->mFaces[i];
-        for (GLuint j = 0; j < face.mNumIndices; ++j) indices.push_back(face.mIndices[j]);
+        const aiFace &face = mesh->mFaces[i];
+        output = std::copy_n(face.mIndices, face.mNumIndices, output);
     }
 
+    if (mesh->mPrimitiveTypes == aiPrimitiveType_TRIANGLE)
+        data.optimization = MeshOptimizer::optimize(vertices, indices);
+
     if (mesh->mMaterialIndex != static_cast<GLuint>(-1))
     {
         aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
+        data.materialIndex = mesh->mMaterialIndex;
 
-        std::vector<Texture> diffuseMaps = loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
-        textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
+        auto diffuseMaps = getMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
+        data.textures.insert(data.textures.end(), diffuseMaps.begin(), diffuseMaps.end());
 
-        std::vector<Texture> specularMaps = loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular");
-        textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
+        auto specularMaps = getMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular");
+        data.textures.insert(data.textures.end(), specularMaps.begin(), specularMaps.end());
     }
 
-    return {vertices, indices, textures};
+    data.computeBounds();
+    return data;
 }
 
-std::vector<Texture> Model::loadMaterialTextures(aiMaterial* mat, aiTextureType type, const std::string &typeName)
+std::vector<TextureRef> Model::getMaterialTextures(aiMaterial* mat, aiTextureType type, const std::string &typeName)
 {
-    std::vector<Texture> textures;
+    std::vector<TextureRef> textures;
     for (GLuint i = 0; i < mat->GetTextureCount(type); ++i)
     {
         aiString str;
         mat->GetTexture(type, i, &str);
 
+        textures.push_back({str.C_Str(), typeName});
+    }
+
+    return textures;
+}
+
+std::vector<std::shared_ptr<Texture>> Model::loadTextures(const std::vector<TextureRef> &refs)
+{
+    std::vector<std::shared_ptr<Texture>> textures;
+    for (const auto &ref: refs)
+    {
         bool skip = false;
         for (const auto &texture: texturesLoaded)
         {
-            if (std::strcmp(texture.path.data(), str.C_Str()) == 0)
+            if (texture->path == ref.path)
             {
                 textures.push_back(texture);
                 skip = true;
@@ -183,7 +292,7 @@ std::vector<Texture> Model::loadMaterialTextures(aiMaterial* mat, aiTextureType
 
         if (!skip)
         {
-            Texture texture(str.C_Str(), typeName);
+            auto texture = std::make_shared<Texture>(ref.path.c_str(), ref.type);
 
             textures.push_back(texture);
             texturesLoaded.push_back(texture);
@@ -1,381 +1,256 @@
 #include "include/objects.h"
+#include "include/optimizer.h"
+#include "include/profiler.h"
+#include "include/transforms.h"
 
-Object::Object(Shader &shader) : shader(shader) {}
-
-Object::~Object()
-{
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
-}
-
-void Object::updateModel()
+namespace
 {
-    model = glm::mat4(1.0f);
-    model = glm::translate(model, position);
-    model = glm::rotate(model, glm::radians(rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
-    model = glm::rotate(model, glm::radians(rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
-    model = glm::rotate(model, glm::radians(rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
-    model = glm::scale(model, scale);
-}
+    std::weak_ptr<Geometry> cubeCache, planeCache;
+    std::array<std::weak_ptr<Geometry>, LOD_COUNT> sphereCache, cylinderCache, coneCache, torusCache;
 
-Cube::Cube(Shader &shader) : Object(shader)
-{
-    vertices = {
-            glm::vec3(-0.5f, -0.5f, 0.5f),
-            glm::vec3(0.5f, -0.5f, 0.5f),
-            glm::vec3(0.5f, 0.5f, 0.5f),
-            glm::vec3(-0.5f, 0.5f, 0.5f),
-
-            glm::vec3(-0.5f, -0.5f, -0.5f),
-            glm::vec3(0.5f, -0.5f, -0.5f),
-            glm::vec3(0.5f, 0.5f, -0.5f),
-            glm::vec3(-0.5f, 0.5f, -0.5f),
-    };
-    indices = {
-            0, 1, 2, 2, 3, 0,
-            1, 5, 6, 6, 2, 1,
-            7, 6, 5, 5, 4, 7,
-            4, 0, 3, 3, 7, 4,
-            4, 5, 1, 1, 0, 4,
-            3, 2, 6, 6, 7, 3
-    };
-
-    updateModel();
-
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
+    std::shared_ptr<Geometry> uploadPrimitive(PrimitiveMesh &mesh)
+    {
+        MeshOptimizer::optimizeVertexCache(mesh.indices, static_cast<GLuint>(mesh.vertices.size()));
 
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, static_cast<long>(vertices.size() * sizeof(glm::vec3)), vertices.data(),
-                 GL_STATIC_DRAW);
+        auto geometry = GeometryPool::get(VERTEX_FORMAT_FULL).allocate<Vertex>(mesh.vertices, mesh.indices,
+                                                                               GL_TRIANGLES);
+        if (!geometry)
+        {
+            std::cerr << "Failed to upload primitive geometry!" << std::endl;
+            exit(EXIT_FAILURE);
+        }
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<long>(indices.size() * sizeof(GLuint)), indices.data(),
-                 GL_STATIC_DRAW);
+        geometry->triangles = std::make_shared<TriangleBVH>(mesh.vertices, mesh.indices);
 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), nullptr);
-    glEnableVertexAttribArray(0);
+        return geometry;
+    }
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
-}
+    std::shared_ptr<Geometry> sharedGeometry(std::weak_ptr<Geometry> &cache, PrimitiveMesh (*build)())
+    {
+        if (auto geometry = cache.lock()) return geometry;
 
-void Cube::draw()
-{
-    shader.setMat4("model", model);
+        PrimitiveMesh mesh = build();
+        auto geometry = uploadPrimitive(mesh);
+        cache = geometry;
 
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, static_cast<GLint>(indices.size()), GL_UNSIGNED_INT, nullptr);
-    glBindVertexArray(0);
-}
+        return geometry;
+    }
 
-Sphere::Sphere(Shader &shader) : Object(shader)
-{
-    const GLint X_SEGMENTS = 64, Y_SEGMENTS = 64;
+    template<typename Surface>
+    std::vector<std::shared_ptr<Geometry>> sharedLods(std::array<std::weak_ptr<Geometry>, LOD_COUNT> &cache)
+    {
+        std::vector<std::shared_ptr<Geometry>> lods;
+        for (auto &level: cache) lods.push_back(level.lock());
+        if (lods.front()) return lods;
 
-    for (GLint y = 0; y <= Y_SEGMENTS; ++y)
-        for (GLint x = 0; x <= X_SEGMENTS; ++x)
+        auto meshes = generateLodChain<Surface>();
+        for (GLuint level = 0; level < LOD_COUNT; ++level)
         {
-            GLfloat xSegment = static_cast<GLfloat>(x) / static_cast<GLfloat>(X_SEGMENTS);
-            GLfloat ySegment = static_cast<GLfloat>(y) / static_cast<GLfloat>(Y_SEGMENTS);
-
-            GLdouble xPos = std::cos(xSegment * 2.0f * M_PI) * std::sin(ySegment * M_PI);
-            GLdouble yPos = std::cos(ySegment * M_PI);
-            GLdouble zPos = std::sin(xSegment * 2.0f * M_PI) * std::sin(ySegment * M_PI);
-
-            vertices.emplace_back(static_cast<GLfloat>(xPos), static_cast<GLfloat>(yPos), static_cast<GLfloat>(zPos));
+            lods[level] = uploadPrimitive(meshes[level]);
+            cache[level] = lods[level];
         }
 
-    bool oddRow = false;
-    for (GLint y = 0; y < Y_SEGMENTS; ++y)
+        return lods;
+    }
+
+    PrimitiveMesh buildCube()
     {
-        if (!oddRow)
-            for (GLint x = 0; x <= X_SEGMENTS; ++x)
-            {
-                indices.emplace_back(y * (X_SEGMENTS + 1) + x);
-                indices.emplace_back((y + 1) * (X_SEGMENTS + 1) + x);
-            }
-        else
-            for (GLint x = X_SEGMENTS; x >= 0; --x)
+        const glm::vec3 normals[] = {
+                glm::vec3(0.0f, 0.0f, 1.0f),
+                glm::vec3(1.0f, 0.0f, 0.0f),
+                glm::vec3(0.0f, 0.0f, -1.0f),
+                glm::vec3(-1.0f, 0.0f, 0.0f),
+                glm::vec3(0.0f, -1.0f, 0.0f),
+                glm::vec3(0.0f, 1.0f, 0.0f),
+        };
+        const glm::vec2 corners[] = {glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 0.0f), glm::vec2(1.0f, 1.0f),
+                                     glm::vec2(0.0f, 1.0f)};
+
+        PrimitiveMesh mesh;
+        for (const auto &normal: normals)
+        {
+            glm::vec3 up = normal.y == 0.0f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(0.0f, 0.0f, -normal.y);
+            glm::vec3 right = glm::cross(up, normal);
+            auto first = static_cast<GLuint>(mesh.vertices.size());
+
+            for (const auto &corner: corners)
             {
-                indices.emplace_back((y + 1) * (X_SEGMENTS + 1) + x);
-                indices.emplace_back(y * (X_SEGMENTS + 1) + x);
+                glm::vec3 position = (normal + right * (corner.x * 2.0f - 1.0f) + up * (corner.y * 2.0f - 1.0f)) * 0.5f;
+                mesh.vertices.push_back({position, normal, glm::vec3(1.0f), corner});
             }
 
-        oddRow = !oddRow;
-    }
-
-    updateModel();
-
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
+            mesh.indices.insert(mesh.indices.end(), {first, first + 1, first + 2, first + 2, first + 3, first});
+        }
 
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, static_cast<long>(vertices.size() * sizeof(glm::vec3)), vertices.data(),
-                 GL_STATIC_DRAW);
+        return mesh;
+    }
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<long>(indices.size() * sizeof(GLuint)), indices.data(),
-                 GL_STATIC_DRAW);
+    PrimitiveMesh buildPlane()
+    {
+        const glm::vec3 up(0.0f, 1.0f, 0.0f), white(1.0f);
+
+        PrimitiveMesh mesh;
+        mesh.vertices = {
+                {glm::vec3(-0.5f, 0.0f, 0.5f), up, white, glm::vec2(0.0f, 0.0f)},
+                {glm::vec3(0.5f, 0.0f, 0.5f), up, white, glm::vec2(1.0f, 0.0f)},
+                {glm::vec3(0.5f, 0.0f, -0.5f), up, white, glm::vec2(1.0f, 1.0f)},
+                {glm::vec3(-0.5f, 0.0f, -0.5f), up, white, glm::vec2(0.0f, 1.0f)},
+        };
+        mesh.indices = {0, 1, 2, 2, 3, 0};
+
+        return mesh;
+    }
+}
 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), nullptr);
-    glEnableVertexAttribArray(0);
+Object::Object(std::shared_ptr<Shader> shader, std::shared_ptr<Geometry> geometry)
+        : world(EntityWorld::get()),
+          handle(geometry ? world.create(Transform(), WorldTransform(), Bounds(geometry->bounds),
+                                         MaterialRef{std::move(shader)}, MeshRef{std::move(geometry)})
+                          : world.create(Transform(), WorldTransform(), Bounds(), MaterialRef{std::move(shader)})),
+          modelUniform(this->shader()->getUniform<glm::mat4>("model")) {}
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
-}
+Object::~Object() { world.destroy(handle); }
 
-void Sphere::draw()
+std::vector<std::shared_ptr<Geometry>> Object::instanceGeometries() const
 {
-    shader.setMat4("model", model);
-
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLE_STRIP, static_cast<GLint>(indices.size()), GL_UNSIGNED_INT, nullptr);
-    glBindVertexArray(0);
+    if (!world.has<MeshRef>(handle)) return {};
+    return {world.get<MeshRef>(handle).geometry};
 }
 
-Cylinder::Cylinder(Shader &shader) : Object(shader)
+void selectLods(EntityWorld &world, const glm::vec3 &cameraPosition, GLfloat projectionScale, JobSystem* jobs)
 {
-    const GLint X_SEGMENTS = 64, Y_SEGMENTS = 64;
+    PROFILE_SCOPE("selectLods");
 
-    for (GLint y = 0; y <= Y_SEGMENTS; ++y)
-        for (GLint x = 0; x <= X_SEGMENTS; ++x)
-        {
-            GLfloat xSegment = static_cast<GLfloat>(x) / static_cast<GLfloat>(X_SEGMENTS);
-            GLfloat ySegment = static_cast<GLfloat>(y) / static_cast<GLfloat>(Y_SEGMENTS);
-
-            GLdouble xPos = std::cos(xSegment * 2.0f * M_PI);
-            GLdouble yPos = ySegment * 2.0f - 1.0f;
-            GLdouble zPos = std::sin(xSegment * 2.0f * M_PI);
-
-            vertices.emplace_back(static_cast<GLfloat>(xPos), static_cast<GLfloat>(yPos), static_cast<GLfloat>(zPos));
-        }
-
-    bool oddRow = false;
-    for (GLint y = 0; y < Y_SEGMENTS; ++y)
+    auto select = [&](const WorldTransform &transform, const Bounds &bounds, LevelOfDetail &lod, MeshRef &mesh)
     {
-        if (!oddRow)
-            for (GLint x = 0; x <= X_SEGMENTS; ++x)
-            {
-                indices.emplace_back(y * (X_SEGMENTS + 1) + x);
-                indices.emplace_back((y + 1) * (X_SEGMENTS + 1) + x);
-            }
-        else
-            for (GLint x = X_SEGMENTS; x >= 0; --x)
-            {
-                indices.emplace_back((y + 1) * (X_SEGMENTS + 1) + x);
-                indices.emplace_back(y * (X_SEGMENTS + 1) + x);
-            }
-
-        oddRow = !oddRow;
-    }
+        if (lod.levels.size() < 2) return;
 
-    updateModel();
+        BoundingSphere sphere = bounds.sphere.transformed(transform.model);
+        GLfloat distance = std::max(glm::length(sphere.center - cameraPosition) - sphere.radius, 0.001f);
+        GLfloat screenSize = 2.0f * sphere.radius * projectionScale / distance;
 
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
+        lod.current = 0;
+        while (lod.current + 1 < lod.levels.size() &&
+               screenSize < LOD_FULL_DETAIL_PIXELS / static_cast<GLfloat>(2 << lod.current))
+            ++lod.current;
 
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, static_cast<long>(vertices.size() * sizeof(glm::vec3)), vertices.data(),
-                 GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<long>(indices.size() * sizeof(GLuint)), indices.data(),
-                 GL_STATIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), nullptr);
-    glEnableVertexAttribArray(0);
+        mesh.geometry = lod.levels[lod.current];
+    };
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    if (jobs) world.parallelForEach<const WorldTransform, const Bounds, LevelOfDetail, MeshRef>(*jobs, select);
+    else world.forEach<const WorldTransform, const Bounds, LevelOfDetail, MeshRef>(select);
 }
 
-void Cylinder::draw()
+bool Object::raycast(const Ray &ray, PickResult &result) const
 {
-    shader.setMat4("model", model);
+    Geometry* mesh = geometry();
+    if (!mesh || !mesh->triangles) return false;
 
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLE_STRIP, static_cast<GLint>(indices.size()), GL_UNSIGNED_INT, nullptr);
-    glBindVertexArray(0);
+    return raycastTriangles(*mesh->triangles, 0, ray, result);
 }
 
-Cone::Cone(Shader &shader) : Object(shader)
+bool Object::raycastTriangles(const TriangleBVH &triangles, GLuint mesh, const Ray &ray, PickResult &result) const
 {
-    const GLint X_SEGMENTS = 64, Y_SEGMENTS = 64;
+    glm::mat4 inverseModel = glm::inverse(model());
 
-    for (GLint y = 0; y <= Y_SEGMENTS; ++y)
-        for (GLint x = 0; x <= X_SEGMENTS; ++x)
-        {
-            GLfloat xSegment = static_cast<GLfloat>(x) / static_cast<GLfloat>(X_SEGMENTS);
-            GLfloat ySegment = static_cast<GLfloat>(y) / static_cast<GLfloat>(Y_SEGMENTS);
+    Ray localRay;
+    localRay.origin = glm::vec3(inverseModel * glm::vec4(ray.origin, 1.0f));
+    localRay.direction = glm::vec3(inverseModel * glm::vec4(ray.direction, 0.0f));
+    localRay.maxDistance = std::min(ray.maxDistance, result.hit.distance);
 
-            GLdouble xPos = std::cos(xSegment * 2.0f * M_PI) * (1.0f - ySegment);
-            GLdouble yPos = ySegment * 2.0f - 1.0f;
-            GLdouble zPos = std::sin(xSegment * 2.0f * M_PI) * (1.0f - ySegment);
+    TriangleHit hit;
+    if (!triangles.raycast(localRay, hit)) return false;
 
-            vertices.emplace_back(static_cast<GLfloat>(xPos), static_cast<GLfloat>(yPos), static_cast<GLfloat>(zPos));
-        }
+    result.object = this;
+    result.mesh = mesh;
+    result.hit = hit;
+    result.position = ray.origin + ray.direction * hit.distance;
 
-    bool oddRow = false;
-    for (GLint y = 0; y < Y_SEGMENTS; ++y)
-    {
-        if (!oddRow)
-            for (GLint x = 0; x <= X_SEGMENTS; ++x)
-            {
-                indices.emplace_back(y * (X_SEGMENTS + 1) + x);
-                indices.emplace_back((y + 1) * (X_SEGMENTS + 1) + x);
-            }
-        else
-            for (GLint x = X_SEGMENTS; x >= 0; --x)
-            {
-                indices.emplace_back((y + 1) * (X_SEGMENTS + 1) + x);
-                indices.emplace_back(y * (X_SEGMENTS + 1) + x);
-            }
+    return true;
+}
 
-        oddRow = !oddRow;
-    }
+void Object::updateModel()
+{
+    const Transform &local = transform();
+    model() = composeTransform(local.position, local.rotation, local.scale);
+}
 
+Cube::Cube(std::shared_ptr<Shader> shader)
+        : Object(std::move(shader), sharedGeometry(cubeCache, buildCube))
+{
     updateModel();
+}
 
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
-
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, static_cast<long>(vertices.size() * sizeof(glm::vec3)), vertices.data(),
-                 GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<long>(indices.size() * sizeof(GLuint)), indices.data(),
-                 GL_STATIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), nullptr);
-    glEnableVertexAttribArray(0);
-
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+void Cube::draw()
+{
+    shader()->set(modelUniform, model());
+    geometry()->draw();
 }
 
-void Cone::draw()
+Sphere::Sphere(std::shared_ptr<Shader> shader)
+        : Object(std::move(shader), sharedLods<SphereSurface>(sphereCache).front())
 {
-    shader.setMat4("model", model);
+    world.add(handle, LevelOfDetail{sharedLods<SphereSurface>(sphereCache)});
 
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLE_STRIP, static_cast<GLint>(indices.size()), GL_UNSIGNED_INT, nullptr);
-    glBindVertexArray(0);
+    updateModel();
 }
 
-Torus::Torus(Shader &shader) : Object(shader)
+void Sphere::draw()
 {
-    const GLint X_SEGMENTS = 64, Y_SEGMENTS = 64;
-
-    for (GLint y = 0; y <= Y_SEGMENTS; ++y)
-        for (GLint x = 0; x <= X_SEGMENTS; ++x)
-        {
-            GLfloat xSegment = static_cast<GLfloat>(x) / static_cast<GLfloat>(X_SEGMENTS);
-            GLfloat ySegment = static_cast<GLfloat>(y) / static_cast<GLfloat>(Y_SEGMENTS);
+    shader()->set(modelUniform, model());
+    geometry()->draw();
+}
 
-            GLdouble xPos = std::cos(xSegment * 2.0f * M_PI);
-            GLdouble yPos = std::cos(ySegment * 2.0f * M_PI);
-            GLdouble zPos = std::sin(xSegment * 2.0f * M_PI);
+Cylinder::Cylinder(std::shared_ptr<Shader> shader)
+        : Object(std::move(shader), sharedLods<CylinderSurface>(cylinderCache).front())
+{
+    world.add(handle, LevelOfDetail{sharedLods<CylinderSurface>(cylinderCache)});
 
-            vertices.emplace_back(static_cast<GLfloat>(xPos), static_cast<GLfloat>(yPos), static_cast<GLfloat>(zPos));
-        }
+    updateModel();
+}
 
-    bool oddRow = false;
-    for (GLint y = 0; y < Y_SEGMENTS; ++y)
-    {
-        if (!oddRow)
-            for (GLint x = 0; x <= X_SEGMENTS; ++x)
-            {
-                indices.emplace_back(y * (X_SEGMENTS + 1) + x);
-                indices.emplace_back((y + 1) * (X_SEGMENTS + 1) + x);
-            }
-        else
-            for (GLint x = X_SEGMENTS; x >= 0; --x)
-            {
-                indices.emplace_back((y + 1) * (X_SEGMENTS + 1) + x);
-                indices.emplace_back(y * (X_SEGMENTS + 1) + x);
-            }
+void Cylinder::draw()
+{
+    shader()->set(modelUniform, model());
+    geometry()->draw();
+}
 
-        oddRow = !oddRow;
-    }
+Cone::Cone(std::shared_ptr<Shader> shader)
+        : Object(std::move(shader), sharedLods<ConeSurface>(coneCache).front())
+{
+    world.add(handle, LevelOfDetail{sharedLods<ConeSurface>(coneCache)});
 
     updateModel();
+}
 
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
-
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, static_cast<long>(vertices.size() * sizeof(glm::vec3)), vertices.data(),
-                 GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<long>(indices.size() * sizeof(GLuint)), indices.data(),
-                 GL_STATIC_DRAW);
+void Cone::draw()
+{
+    shader()->set(modelUniform, model());
+    geometry()->draw();
+}
 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), nullptr);
-    glEnableVertexAttribArray(0);
+Torus::Torus(std::shared_ptr<Shader> shader)
+        : Object(std::move(shader), sharedLods<TorusSurface>(torusCache).front())
+{
+    world.add(handle, LevelOfDetail{sharedLods<TorusSurface>(torusCache)});
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    updateModel();
 }
 
 void Torus::draw()
 {
-    shader.setMat4("model", model);
-
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLE_STRIP, static_cast<GLint>(indices.size()), GL_UNSIGNED_INT, nullptr);
-    glBindVertexArray(0);
+    shader()->set(modelUniform, model());
+    geometry()->draw();
 }
 
-Plane::Plane(Shader &shader) : Object(shader)
+Plane::Plane(std::shared_ptr<Shader> shader)
+        : Object(std::move(shader), sharedGeometry(planeCache, buildPlane))
 {
-    vertices = {
-            glm::vec3(-0.5f, 0.0f, 0.5f),
-            glm::vec3(0.5f, 0.0f, 0.5f),
-            glm::vec3(0.5f, 0.0f, -0.5f),
-            glm::vec3(-0.5f, 0.0f, -0.5f),
-    };
-    indices = {0, 1, 2, 2, 3, 0};
-
     updateModel();
-
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
-
-    glBindVertexArray(VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, static_cast<long>(vertices.size() * sizeof(glm::vec3)), vertices.data(),
-                 GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<long>(indices.size() * sizeof(GLuint)), indices.data(),
-                 GL_STATIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), nullptr);
-    glEnableVertexAttribArray(0);
-
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
 }
 
 void Plane::draw()
 {
-    shader.setMat4("model", model);
-
-    glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, static_cast<GLint>(indices.size()), GL_UNSIGNED_INT, nullptr);
-    glBindVertexArray(0);
+    shader()->set(modelUniform, model());
+    geometry()->draw();
 }
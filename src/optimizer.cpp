@@ -0,0 +1,329 @@
+#include "include/optimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <numeric>
+
+#include "include/profiler.h"
+
+namespace
+{
+    constexpr GLuint FORSYTH_CACHE_SIZE = 32, INVALID_INDEX = std::numeric_limits<GLuint>::max();
+
+    GLfloat forsythVertexScore(GLint cachePosition, GLuint remainingTriangles)
+    {
+        if (remainingTriangles == 0) return -1.0f;
+
+        GLfloat score = 0.0f;
+        if (cachePosition >= 0)
+        {
+            if (cachePosition < 3) score = 0.75f;
+            else
+                score = std::pow(1.0f - static_cast<GLfloat>(cachePosition - 3) /
+                                        static_cast<GLfloat>(FORSYTH_CACHE_SIZE - 3), 1.5f);
+        }
+
+        return score + 2.0f / std::sqrt(static_cast<GLfloat>(remainingTriangles));
+    }
+
+    std::uint64_t hashVertex(const Vertex &vertex)
+    {
+        std::uint32_t words[sizeof(Vertex) / sizeof(std::uint32_t)];
+        std::memcpy(words, &vertex, sizeof(Vertex));
+
+        std::uint64_t hash = 0xCBF29CE484222325ull;
+        for (std::uint32_t word: words) hash = (hash ^ word) * 0x100000001B3ull;
+
+        return hash;
+    }
+}
+
+CacheStats MeshOptimizer::analyzeVertexCache(const std::vector<GLuint> &indices, GLuint vertexCount, GLuint cacheSize)
+{
+    CacheStats stats;
+    if (indices.empty() || vertexCount == 0) return stats;
+
+    std::vector<GLuint> timestamps(vertexCount, 0);
+    std::vector<bool> referenced(vertexCount, false);
+    GLuint time = cacheSize + 1, misses = 0, uniqueVertices = 0;
+
+    for (GLuint index: indices)
+    {
+        if (!referenced[index])
+        {
+            referenced[index] = true;
+            ++uniqueVertices;
+        }
+
+        if (time - timestamps[index] > cacheSize)
+        {
+            timestamps[index] = time++;
+            ++misses;
+        }
+    }
+
+    stats.acmr = static_cast<GLfloat>(misses) / static_cast<GLfloat>(indices.size() / 3);
+    stats.atvr = static_cast<GLfloat>(misses) / static_cast<GLfloat>(uniqueVertices);
+
+    return stats;
+}
+
+void MeshOptimizer::weldVertices(std::vector<Vertex> &vertices, std::vector<GLuint> &indices)
+{
+    PROFILE_SCOPE("MeshOptimizer::weldVertices");
+
+    size_t tableSize = 1;
+    while (tableSize < vertices.size() * 2) tableSize <<= 1;
+
+    std::vector<GLuint> table(tableSize, INVALID_INDEX), remap(vertices.size());
+    std::vector<Vertex> unique;
+    unique.reserve(vertices.size());
+
+    for (size_t i = 0; i < vertices.size(); ++i)
+    {
+        size_t slot = hashVertex(vertices[i]) & (tableSize - 1);
+        while (table[slot] != INVALID_INDEX &&
+               std::memcmp(&unique[table[slot]], &vertices[i], sizeof(Vertex)) != 0)
+            slot = (slot + 1) & (tableSize - 1);
+
+        if (table[slot] == INVALID_INDEX)
+        {
+            table[slot] = static_cast<GLuint>(unique.size());
+            unique.push_back(vertices[i]);
+        }
+
+        remap[i] = table[slot];
+    }
+
+    for (auto &index: indices) index = remap[index];
+    vertices.swap(unique);
+}
+
+void MeshOptimizer::optimizeVertexCache(std::vector<GLuint> &indices, GLuint vertexCount)
+{
+    PROFILE_SCOPE("MeshOptimizer::optimizeVertexCache");
+
+    auto triangleCount = static_cast<GLuint>(indices.size() / 3);
+    if (triangleCount == 0) return;
+
+    std::vector<GLuint> remaining(vertexCount, 0), offsets(vertexCount + 1, 0), adjacency(indices.size());
+    for (GLuint index: indices) ++remaining[index];
+    for (GLuint v = 0; v < vertexCount; ++v) offsets[v + 1] = offsets[v] + remaining[v];
+
+    std::vector<GLuint> cursor(offsets.begin(), offsets.end() - 1);
+    for (GLuint triangle = 0; triangle < triangleCount; ++triangle)
+        for (GLuint corner = 0; corner < 3; ++corner) adjacency[cursor[indices[triangle * 3 + corner]]++] = triangle;
+
+    std::vector<GLint> cachePosition(vertexCount, -1);
+    std::vector<GLfloat> vertexScores(vertexCount), triangleScores(triangleCount, 0.0f);
+    std::vector<bool> emitted(triangleCount, false);
+
+    for (GLuint v = 0; v < vertexCount; ++v) vertexScores[v] = forsythVertexScore(-1, remaining[v]);
+    for (GLuint triangle = 0; triangle < triangleCount; ++triangle)
+        for (GLuint corner = 0; corner < 3; ++corner)
+            triangleScores[triangle] += vertexScores[indices[triangle * 3 + corner]];
+
+    std::vector<GLuint> output, cache, nextCache;
+    output.reserve(indices.size());
+    cache.reserve(FORSYTH_CACHE_SIZE + 3);
+    nextCache.reserve(FORSYTH_CACHE_SIZE + 3);
+
+    GLint best = static_cast<GLint>(std::max_element(triangleScores.begin(), triangleScores.end()) -
+                                    triangleScores.begin());
+    GLuint scanCursor = 0;
+
+    while (output.size() < indices.size())
+    {
+        if (best < 0)
+        {
+            while (emitted[scanCursor]) ++scanCursor;
+            best = static_cast<GLint>(scanCursor);
+        }
+
+        auto triangle = static_cast<GLuint>(best);
+        const GLuint* corners = &indices[triangle * 3];
+        emitted[triangle] = true;
+
+        nextCache.clear();
+        for (GLuint corner = 0; corner < 3; ++corner)
+        {
+            GLuint vertex = corners[corner];
+            output.push_back(vertex);
+            nextCache.push_back(vertex);
+
+            GLuint* begin = &adjacency[offsets[vertex]];
+            GLuint* end = begin + remaining[vertex];
+            std::iter_swap(std::find(begin, end, triangle), end - 1);
+            --remaining[vertex];
+        }
+
+        for (GLuint vertex: cache)
+            if (vertex != corners[0] && vertex != corners[1] && vertex != corners[2]) nextCache.push_back(vertex);
+
+        for (size_t i = 0; i < nextCache.size(); ++i)
+        {
+            GLuint vertex = nextCache[i];
+            cachePosition[vertex] = i < FORSYTH_CACHE_SIZE ? static_cast<GLint>(i) : -1;
+            vertexScores[vertex] = forsythVertexScore(cachePosition[vertex], remaining[vertex]);
+        }
+
+        best = -1;
+        GLfloat bestScore = -std::numeric_limits<GLfloat>::max();
+
+        for (GLuint vertex: nextCache)
+            for (GLuint i = offsets[vertex]; i < offsets[vertex] + remaining[vertex]; ++i)
+            {
+                GLuint neighbour = adjacency[i];
+                const GLuint* neighbourCorners = &indices[neighbour * 3];
+
+                triangleScores[neighbour] = vertexScores[neighbourCorners[0]] + vertexScores[neighbourCorners[1]] +
+                                            vertexScores[neighbourCorners[2]];
+                if (triangleScores[neighbour] > bestScore)
+                {
+                    bestScore = triangleScores[neighbour];
+                    best = static_cast<GLint>(neighbour);
+                }
+            }
+
+        if (nextCache.size() > FORSYTH_CACHE_SIZE) nextCache.resize(FORSYTH_CACHE_SIZE);
+        cache.swap(nextCache);
+    }
+
+    indices.swap(output);
+}
+
+void MeshOptimizer::optimizeOverdraw(std::vector<GLuint> &indices, const std::vector<Vertex> &vertices,
+                                     GLfloat threshold)
+{
+    PROFILE_SCOPE("MeshOptimizer::optimizeOverdraw");
+
+    auto triangleCount = static_cast<GLuint>(indices.size() / 3);
+    if (triangleCount < 2) return;
+
+    std::vector<GLuint> clusters, timestamps(vertices.size(), 0);
+    GLuint time = SIMULATED_CACHE_SIZE + 1;
+
+    for (GLuint triangle = 0; triangle < triangleCount; ++triangle)
+    {
+        GLuint misses = 0;
+        for (GLuint corner = 0; corner < 3; ++corner)
+        {
+            GLuint index = indices[triangle * 3 + corner];
+            if (time - timestamps[index] > SIMULATED_CACHE_SIZE)
+            {
+                timestamps[index] = time++;
+                ++misses;
+            }
+        }
+
+        if (misses == 3 || triangle == 0) clusters.push_back(triangle);
+    }
+
+    if (clusters.size() < 2) return;
+    clusters.push_back(triangleCount);
+
+    struct Cluster
+    {
+        GLuint begin, end;
+        glm::vec3 centroid, normal;
+        GLfloat area, sortKey;
+    };
+
+    std::vector<Cluster> sorted;
+    sorted.reserve(clusters.size() - 1);
+
+    glm::vec3 meshCentroid(0.0f);
+    GLfloat meshArea = 0.0f;
+
+    for (size_t c = 0; c + 1 < clusters.size(); ++c)
+    {
+        Cluster cluster = {clusters[c], clusters[c + 1], glm::vec3(0.0f), glm::vec3(0.0f), 0.0f, 0.0f};
+
+        for (GLuint triangle = cluster.begin; triangle < cluster.end; ++triangle)
+        {
+            const glm::vec3 &a = vertices[indices[triangle * 3]].position;
+            const glm::vec3 &b = vertices[indices[triangle * 3 + 1]].position;
+            const glm::vec3 &c2 = vertices[indices[triangle * 3 + 2]].position;
+
+            glm::vec3 normal = glm::cross(b - a, c2 - a);
+            GLfloat area = glm::length(normal);
+
+            cluster.centroid += (a + b + c2) * (area / 3.0f);
+            cluster.normal += normal;
+            cluster.area += area;
+        }
+
+        meshCentroid += cluster.centroid;
+        meshArea += cluster.area;
+
+        if (cluster.area > 0.0f) cluster.centroid /= cluster.area;
+        GLfloat normalLength = glm::length(cluster.normal);
+        if (normalLength > 0.0f) cluster.normal /= normalLength;
+
+        sorted.push_back(cluster);
+    }
+
+    if (meshArea > 0.0f) meshCentroid /= meshArea;
+    for (auto &cluster: sorted) cluster.sortKey = glm::dot(cluster.centroid - meshCentroid, cluster.normal);
+
+    std::stable_sort(sorted.begin(), sorted.end(), [](const Cluster &a, const Cluster &b)
+    {
+        return a.sortKey > b.sortKey;
+    });
+
+    std::vector<GLuint> reordered;
+    reordered.reserve(indices.size());
+    for (const auto &cluster: sorted)
+        reordered.insert(reordered.end(), indices.begin() + cluster.begin * 3, indices.begin() + cluster.end * 3);
+
+    auto vertexCount = static_cast<GLuint>(vertices.size());
+    if (analyzeVertexCache(reordered, vertexCount).acmr <= analyzeVertexCache(indices, vertexCount).acmr * threshold)
+        indices.swap(reordered);
+}
+
+void MeshOptimizer::optimizeVertexFetch(std::vector<Vertex> &vertices, std::vector<GLuint> &indices)
+{
+    PROFILE_SCOPE("MeshOptimizer::optimizeVertexFetch");
+
+    std::vector<GLuint> remap(vertices.size(), INVALID_INDEX);
+    std::vector<Vertex> ordered;
+    ordered.reserve(vertices.size());
+
+    for (auto &index: indices)
+    {
+        if (remap[index] == INVALID_INDEX)
+        {
+            remap[index] = static_cast<GLuint>(ordered.size());
+            ordered.push_back(vertices[index]);
+        }
+
+        index = remap[index];
+    }
+
+    vertices.swap(ordered);
+}
+
+OptimizationReport MeshOptimizer::optimize(std::vector<Vertex> &vertices, std::vector<GLuint> &indices)
+{
+    PROFILE_SCOPE("MeshOptimizer::optimize");
+
+    OptimizationReport report;
+    report.verticesBefore = static_cast<GLuint>(vertices.size());
+    report.before = analyzeVertexCache(indices, report.verticesBefore);
+
+    if (indices.size() % 3 == 0 && !indices.empty())
+    {
+        weldVertices(vertices, indices);
+        optimizeVertexCache(indices, static_cast<GLuint>(vertices.size()));
+        optimizeOverdraw(indices, vertices);
+        optimizeVertexFetch(vertices, indices);
+    }
+
+    report.verticesAfter = static_cast<GLuint>(vertices.size());
+    report.after = analyzeVertexCache(indices, report.verticesAfter);
+
+    return report;
+}
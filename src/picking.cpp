@@ -0,0 +1,401 @@
+#include "include/picking.h"
+#include "include/profiler.h"
+
+#include <algorithm>
+#include <numeric>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PICKING_SSE
+#include <emmintrin.h>
+#endif
+
+struct TriangleBVH::BuildState
+{
+    std::span<const Vertex> vertices;
+    std::span<const GLuint> indices;
+    std::vector<AABB> boxes;
+    std::vector<glm::vec3> centroids;
+    std::vector<GLuint> order;
+};
+
+namespace
+{
+    constexpr GLfloat PARALLEL_EPSILON = 1e-8f;
+
+    AABB rangeBounds(const std::vector<AABB> &boxes, std::span<const GLuint> order, bool centroids)
+    {
+        AABB result = boxes[order.front()];
+        if (centroids) result = {result.center(), result.center()};
+
+        for (GLuint id: order.subspan(1))
+        {
+            if (!centroids) result.expand(boxes[id]);
+            else result.expand({boxes[id].center(), boxes[id].center()});
+        }
+
+        return result;
+    }
+}
+
+TriangleBVH::TriangleBVH(std::span<const Vertex> vertices, std::span<const GLuint> indices)
+{
+    PROFILE_SCOPE("TriangleBVH::build");
+
+    triangles = indices.size() / 3;
+    if (triangles == 0) return;
+
+    BuildState state;
+    state.vertices = vertices;
+    state.indices = indices;
+    state.boxes.resize(triangles);
+    state.centroids.resize(triangles);
+    state.order.resize(triangles);
+    std::iota(state.order.begin(), state.order.end(), 0u);
+
+    for (size_t i = 0; i < triangles; ++i)
+    {
+        const glm::vec3 &a = vertices[indices[i * 3]].position, &b = vertices[indices[i * 3 + 1]].position,
+                &c = vertices[indices[i * 3 + 2]].position;
+
+        state.boxes[i] = {glm::min(a, glm::min(b, c)), glm::max(a, glm::max(b, c))};
+        state.centroids[i] = state.boxes[i].center();
+    }
+
+    nodes.reserve(triangles / 2 + 1);
+    blocks.reserve(triangles / 2 + 1);
+    nodes.emplace_back();
+    buildNode(state, 0, 0, static_cast<GLuint>(triangles));
+}
+
+void TriangleBVH::buildNode(BuildState &state, GLuint node, GLuint first, GLuint count)
+{
+    std::pair<GLuint, GLuint> ranges[WIDTH] = {{first, count}};
+    GLuint rangeCount = 1;
+
+    while (rangeCount < WIDTH)
+    {
+        GLuint largest = WIDTH;
+        for (GLuint i = 0; i < rangeCount; ++i)
+            if (ranges[i].second > MAX_LEAF_SIZE && (largest == WIDTH || ranges[i].second > ranges[largest].second))
+                largest = i;
+
+        if (largest == WIDTH) break;
+
+        auto [rangeFirst, rangeSize] = ranges[largest];
+        GLuint middle = split(state, rangeFirst, rangeSize);
+        ranges[largest] = {rangeFirst, middle - rangeFirst};
+        ranges[rangeCount++] = {middle, rangeFirst + rangeSize - middle};
+    }
+
+    for (GLuint lane = 0; lane < WIDTH; ++lane)
+    {
+        if (lane >= rangeCount)
+        {
+            Node &empty = nodes[node];
+            empty.minX[lane] = empty.minY[lane] = empty.minZ[lane] = std::numeric_limits<GLfloat>::max();
+            empty.maxX[lane] = empty.maxY[lane] = empty.maxZ[lane] = std::numeric_limits<GLfloat>::lowest();
+            empty.children[lane] = EMPTY_CHILD;
+            continue;
+        }
+
+        auto [rangeFirst, rangeSize] = ranges[lane];
+        AABB box = rangeBounds(state.boxes, std::span(state.order).subspan(rangeFirst, rangeSize), false);
+
+        GLuint child;
+        if (rangeSize <= MAX_LEAF_SIZE) child = LEAF_FLAG | buildLeaf(state, rangeFirst, rangeSize);
+        else
+        {
+            child = static_cast<GLuint>(nodes.size());
+            nodes.emplace_back();
+            buildNode(state, child, rangeFirst, rangeSize);
+        }
+
+        Node &current = nodes[node];
+        current.minX[lane] = box.min.x;
+        current.minY[lane] = box.min.y;
+        current.minZ[lane] = box.min.z;
+        current.maxX[lane] = box.max.x;
+        current.maxY[lane] = box.max.y;
+        current.maxZ[lane] = box.max.z;
+        current.children[lane] = child;
+    }
+}
+
+GLuint TriangleBVH::buildLeaf(const BuildState &state, GLuint first, GLuint count)
+{
+    TriangleBlock &block = blocks.emplace_back();
+
+    for (GLuint lane = 0; lane < WIDTH; ++lane)
+    {
+        glm::vec3 origin(0.0f), edge1(0.0f), edge2(0.0f);
+        block.ids[lane] = TriangleHit::INVALID_TRIANGLE;
+
+        if (lane < count)
+        {
+            GLuint id = state.order[first + lane];
+            origin = state.vertices[state.indices[id * 3]].position;
+            edge1 = state.vertices[state.indices[id * 3 + 1]].position - origin;
+            edge2 = state.vertices[state.indices[id * 3 + 2]].position - origin;
+            block.ids[lane] = id;
+        }
+
+        block.originX[lane] = origin.x;
+        block.originY[lane] = origin.y;
+        block.originZ[lane] = origin.z;
+        block.edge1X[lane] = edge1.x;
+        block.edge1Y[lane] = edge1.y;
+        block.edge1Z[lane] = edge1.z;
+        block.edge2X[lane] = edge2.x;
+        block.edge2Y[lane] = edge2.y;
+        block.edge2Z[lane] = edge2.z;
+    }
+
+    return static_cast<GLuint>(blocks.size() - 1);
+}
+
+GLuint TriangleBVH::split(BuildState &state, GLuint first, GLuint count)
+{
+    auto begin = state.order.begin() + first, end = begin + count;
+    AABB centroidBounds = rangeBounds(state.boxes, std::span(state.order).subspan(first, count), true);
+    glm::vec3 extent = centroidBounds.max - centroidBounds.min;
+
+    GLint bestAxis = -1;
+    GLuint bestSplit = 0;
+    GLfloat bestCost = std::numeric_limits<GLfloat>::max();
+
+    for (GLint axis = 0; axis < 3; ++axis)
+    {
+        if (extent[axis] <= 0.0f) continue;
+
+        AABB bins[BINS];
+        GLuint binCounts[BINS] = {};
+        GLfloat scale = static_cast<GLfloat>(BINS) / extent[axis];
+
+        for (auto it = begin; it != end; ++it)
+        {
+            auto bin = std::min(BINS - 1, static_cast<GLuint>((state.centroids[*it][axis] -
+                                                               centroidBounds.min[axis]) * scale));
+            if (binCounts[bin]++ == 0) bins[bin] = state.boxes[*it];
+            else bins[bin].expand(state.boxes[*it]);
+        }
+
+        GLfloat leftCost[BINS] = {};
+        AABB sweep;
+        GLuint sweepCount = 0;
+
+        for (GLuint i = 0; i < BINS - 1; ++i)
+        {
+            if (binCounts[i] > 0)
+            {
+                if (sweepCount == 0) sweep = bins[i];
+                else sweep.expand(bins[i]);
+            }
+
+            sweepCount += binCounts[i];
+            leftCost[i] = sweepCount > 0 ? sweep.surfaceArea() * static_cast<GLfloat>(sweepCount) : 0.0f;
+        }
+
+        sweepCount = 0;
+        for (GLuint i = BINS - 1; i > 0; --i)
+        {
+            if (binCounts[i] > 0)
+            {
+                if (sweepCount == 0) sweep = bins[i];
+                else sweep.expand(bins[i]);
+            }
+
+            sweepCount += binCounts[i];
+            if (sweepCount == 0 || sweepCount == count) continue;
+
+            GLfloat cost = leftCost[i - 1] + sweep.surfaceArea() * static_cast<GLfloat>(sweepCount);
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestAxis = axis;
+                bestSplit = i;
+            }
+        }
+    }
+
+    if (bestAxis >= 0)
+    {
+        GLfloat scale = static_cast<GLfloat>(BINS) / extent[bestAxis];
+        auto middle = std::partition(begin, end, [&](GLuint id)
+        {
+            return static_cast<GLuint>((state.centroids[id][bestAxis] - centroidBounds.min[bestAxis]) * scale) <
+                   bestSplit;
+        });
+
+        if (middle != begin && middle != end) return first + static_cast<GLuint>(middle - begin);
+    }
+
+    GLint axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+    auto middle = begin + count / 2;
+    std::nth_element(begin, middle, end, [&](GLuint a, GLuint b)
+    {
+        return state.centroids[a][axis] < state.centroids[b][axis];
+    });
+
+    return first + count / 2;
+}
+
+bool TriangleBVH::raycast(const Ray &ray, TriangleHit &hit) const
+{
+    if (nodes.empty()) return false;
+
+    glm::vec3 inverseDirection = 1.0f / ray.direction;
+    GLfloat closest = std::min(ray.maxDistance, hit.distance);
+    bool found = false;
+
+    TraversalStack<STACK_SIZE> stack;
+    stack.push(0);
+
+    while (!stack.empty())
+    {
+        GLuint current = stack.pop();
+
+        if (current & LEAF_FLAG)
+        {
+            const TriangleBlock &block = blocks[current & ~LEAF_FLAG];
+            alignas(16) GLfloat t[WIDTH], u[WIDTH], v[WIDTH];
+
+            GLint mask = intersectBlock(block, ray, closest, t, u, v);
+            for (GLuint lane = 0; lane < WIDTH; ++lane)
+            {
+                if (!(mask & (1 << lane)) || block.ids[lane] == TriangleHit::INVALID_TRIANGLE || t[lane] >= closest)
+                    continue;
+
+                closest = t[lane];
+                hit = {block.ids[lane], t[lane], glm::vec2(u[lane], v[lane])};
+                found = true;
+            }
+
+            continue;
+        }
+
+        const Node &node = nodes[current];
+        alignas(16) GLfloat distances[WIDTH];
+        GLint mask = intersectNode(node, ray, inverseDirection, closest, distances);
+
+        GLuint order[WIDTH], hits = 0;
+        for (GLuint lane = 0; lane < WIDTH; ++lane)
+            if ((mask & (1 << lane)) && node.children[lane] != EMPTY_CHILD) order[hits++] = lane;
+
+        // Insertion sort, farthest first, so the nearest child is popped next.
+        for (GLuint i = 1; i < hits; ++i)
+        {
+            GLuint lane = order[i], j = i;
+            for (; j > 0 && distances[order[j - 1]] < distances[lane]; --j) order[j] = order[j - 1];
+            order[j] = lane;
+        }
+
+        for (GLuint i = 0; i < hits; ++i) stack.push(node.children[order[i]]);
+    }
+
+    return found;
+}
+
+GLint TriangleBVH::intersectNode(const Node &node, const Ray &ray, const glm::vec3 &inverseDirection, GLfloat closest,
+                                 GLfloat* distances)
+{
+    const GLfloat *minX = node.minX, *minY = node.minY, *minZ = node.minZ, *maxX = node.maxX, *maxY = node.maxY,
+            *maxZ = node.maxZ;
+
+    #if defined(PICKING_SSE)
+    __m128 ox = _mm_set1_ps(ray.origin.x), oy = _mm_set1_ps(ray.origin.y), oz = _mm_set1_ps(ray.origin.z);
+    __m128 ix = _mm_set1_ps(inverseDirection.x), iy = _mm_set1_ps(inverseDirection.y),
+            iz = _mm_set1_ps(inverseDirection.z);
+
+    __m128 t0x = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(minX), ox), ix);
+    __m128 t1x = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(maxX), ox), ix);
+    __m128 t0y = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(minY), oy), iy);
+    __m128 t1y = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(maxY), oy), iy);
+    __m128 t0z = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(minZ), oz), iz);
+    __m128 t1z = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(maxZ), oz), iz);
+
+    __m128 nearest = _mm_max_ps(_mm_max_ps(_mm_min_ps(t0x, t1x), _mm_min_ps(t0y, t1y)),
+                                _mm_max_ps(_mm_min_ps(t0z, t1z), _mm_setzero_ps()));
+    __m128 farthest = _mm_min_ps(_mm_min_ps(_mm_max_ps(t0x, t1x), _mm_max_ps(t0y, t1y)),
+                                 _mm_min_ps(_mm_max_ps(t0z, t1z), _mm_set1_ps(closest)));
+
+    _mm_store_ps(distances, nearest);
+    return _mm_movemask_ps(_mm_cmple_ps(nearest, farthest));
+    #else
+    GLint mask = 0;
+    for (GLint lane = 0; lane < 4; ++lane)
+    {
+        AABB box{glm::vec3(minX[lane], minY[lane], minZ[lane]), glm::vec3(maxX[lane], maxY[lane], maxZ[lane])};
+        if (Ray{ray.origin, ray.direction, closest}.intersects(box, inverseDirection, distances[lane]))
+            mask |= 1 << lane;
+    }
+
+    return mask;
+    #endif
+}
+
+GLint TriangleBVH::intersectBlock(const TriangleBlock &block, const Ray &ray, GLfloat closest, GLfloat* t, GLfloat* u,
+                                  GLfloat* v)
+{
+    #if defined(PICKING_SSE)
+    __m128 e1x = _mm_load_ps(block.edge1X), e1y = _mm_load_ps(block.edge1Y), e1z = _mm_load_ps(block.edge1Z);
+    __m128 e2x = _mm_load_ps(block.edge2X), e2y = _mm_load_ps(block.edge2Y), e2z = _mm_load_ps(block.edge2Z);
+    __m128 dx = _mm_set1_ps(ray.direction.x), dy = _mm_set1_ps(ray.direction.y),
+            dz = _mm_set1_ps(ray.direction.z);
+
+    __m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+    __m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+    __m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+    __m128 determinant = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+    __m128 inverse = _mm_div_ps(_mm_set1_ps(1.0f), determinant);
+
+    __m128 sx = _mm_sub_ps(_mm_set1_ps(ray.origin.x), _mm_load_ps(block.originX));
+    __m128 sy = _mm_sub_ps(_mm_set1_ps(ray.origin.y), _mm_load_ps(block.originY));
+    __m128 sz = _mm_sub_ps(_mm_set1_ps(ray.origin.z), _mm_load_ps(block.originZ));
+    __m128 bu = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, px), _mm_mul_ps(sy, py)), _mm_mul_ps(sz, pz)),
+                           inverse);
+
+    __m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+    __m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+    __m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+    __m128 bv = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)),
+                           inverse);
+    __m128 distance = _mm_mul_ps(
+            _mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), inverse);
+
+    const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+    __m128 absolute = _mm_andnot_ps(_mm_set1_ps(-0.0f), determinant);
+    __m128 valid = _mm_cmpgt_ps(absolute, _mm_set1_ps(PARALLEL_EPSILON));
+    valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpge_ps(bu, zero), _mm_cmpge_ps(bv, zero)));
+    valid = _mm_and_ps(valid, _mm_cmple_ps(_mm_add_ps(bu, bv), one));
+    valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpgt_ps(distance, zero),
+                                         _mm_cmplt_ps(distance, _mm_set1_ps(closest))));
+
+    _mm_store_ps(t, distance);
+    _mm_store_ps(u, bu);
+    _mm_store_ps(v, bv);
+    return _mm_movemask_ps(valid);
+    #else
+    GLint mask = 0;
+    for (GLint lane = 0; lane < 4; ++lane)
+    {
+        glm::vec3 origin(block.originX[lane], block.originY[lane], block.originZ[lane]);
+        glm::vec3 edge1(block.edge1X[lane], block.edge1Y[lane], block.edge1Z[lane]);
+        glm::vec3 edge2(block.edge2X[lane], block.edge2Y[lane], block.edge2Z[lane]);
+
+        glm::vec3 p = glm::cross(ray.direction, edge2);
+        GLfloat determinant = glm::dot(edge1, p);
+        if (std::abs(determinant) <= PARALLEL_EPSILON) continue;
+
+        GLfloat inverse = 1.0f / determinant;
+        glm::vec3 s = ray.origin - origin, q = glm::cross(s, edge1);
+        u[lane] = glm::dot(s, p) * inverse;
+        v[lane] = glm::dot(ray.direction, q) * inverse;
+        t[lane] = glm::dot(edge2, q) * inverse;
+
+        if (u[lane] >= 0.0f && v[lane] >= 0.0f && u[lane] + v[lane] <= 1.0f && t[lane] > 0.0f && t[lane] < closest)
+            mask |= 1 << lane;
+    }
+
+    return mask;
+    #endif
+}
@@ -0,0 +1,81 @@
+#include "include/profiler.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+void Profiler::setEnabled(bool value) { enabled.store(value, std::memory_order_relaxed); }
+
+void Profiler::setGpuMarkers(bool value)
+{
+    if (value && !GLEW_KHR_debug && !GLEW_VERSION_4_3)
+    {
+        std::cerr << "GPU debug markers require KHR_debug or OpenGL 4.3!" << std::endl;
+        value = false;
+    }
+
+    gpuMarkers.store(value, std::memory_order_relaxed);
+}
+
+Profiler::ThreadBuffer* Profiler::registerThread()
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+
+    auto buffer = std::make_unique<ThreadBuffer>();
+    buffer->threadId = std::this_thread::get_id();
+    buffer->index = static_cast<GLuint>(registry.size());
+
+    return registry.emplace_back(std::move(buffer)).get();
+}
+
+bool Profiler::writeTrace(const std::string &path)
+{
+    std::ofstream file(path);
+    if (!file.is_open())
+    {
+        std::cerr << "Failed to write profiler trace to \"" << path << "\"" << std::endl;
+        return false;
+    }
+
+    auto elapsed = std::chrono::duration<GLdouble, std::micro>(std::chrono::steady_clock::now() - epochTime).count();
+    GLdouble ticksPerMicrosecond = static_cast<GLdouble>(now() - epochTicks) / std::max(elapsed, 1.0);
+    auto toMicroseconds = [&](std::uint64_t ticks)
+    {
+        return static_cast<GLdouble>(static_cast<std::int64_t>(ticks - epochTicks)) / ticksPerMicrosecond;
+    };
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    size_t eventCount = 0;
+
+    file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    for (const auto &buffer: registry)
+    {
+        file << (buffer->index ? ",\n" : "") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": "
+             << buffer->index << ", \"args\": {\"name\": \""
+             << (buffer->threadId == mainThread ? "Main" : "Worker " + std::to_string(buffer->index)) << "\"}}";
+
+        std::uint64_t head = buffer->head.load(std::memory_order_acquire);
+        std::uint64_t first = head > BUFFER_CAPACITY ? head - BUFFER_CAPACITY : 0;
+
+        std::vector<ProfileEvent> events;
+        events.reserve(head - first);
+        for (std::uint64_t i = first; i < head; ++i) events.push_back(buffer->events[i % BUFFER_CAPACITY]);
+
+        std::uint64_t latest = buffer->head.load(std::memory_order_acquire);
+        std::uint64_t oldestValid = latest > BUFFER_CAPACITY ? latest - BUFFER_CAPACITY : 0;
+        size_t skip = oldestValid > first ? static_cast<size_t>(std::min(oldestValid - first, head - first)) : 0;
+
+        for (size_t i = skip; i < events.size(); ++i)
+        {
+            const ProfileEvent &event = events[i];
+            file << ",\n{\"name\": \"" << event.name << "\", \"ph\": \"X\", \"pid\": 0, \"tid\": " << buffer->index
+                 << ", \"ts\": " << toMicroseconds(event.start) << ", \"dur\": "
+                 << toMicroseconds(event.end) - toMicroseconds(event.start) << "}";
+            ++eventCount;
+        }
+    }
+    file << "\n]}\n";
+
+    std::cout << "Wrote " << eventCount << " profiler events to \"" << path << "\"" << std::endl;
+    return true;
+}
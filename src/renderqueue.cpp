@@ -0,0 +1,223 @@
+#include "include/renderqueue.h"
+#include "include/indirect.h"
+#include "include/profiler.h"
+
+#include <algorithm>
+#include <array>
+#include <utility>
+
+namespace
+{
+    GLuint nextMaterialId = 1;
+
+    std::uint64_t field(GLuint value, GLuint bits) { return value & ((std::uint64_t(1) << bits) - 1); }
+}
+
+Material::Material(std::vector<std::shared_ptr<Texture>> textures)
+        : id(nextMaterialId++), textures(std::move(textures)) {}
+
+void Material::apply(const Shader &shader, Uniform<bool> hasTexture) const
+{
+    for (GLuint unit = 0; unit < textures.size(); ++unit) textures[unit]->bind(GL_TEXTURE0 + unit);
+    shader.set(hasTexture, !textures.empty());
+}
+
+std::uint64_t RenderQueue::makeKey(GpuPass pass, bool translucent, GLuint program, GLuint material,
+                                   GLuint vertexArray, GLfloat depth)
+{
+    constexpr GLuint maxDepth = (1u << DEPTH_BITS) - 1, stateBits = PROGRAM_BITS + MATERIAL_BITS + VERTEX_ARRAY_BITS;
+    auto quantised = static_cast<GLuint>(std::clamp(depth, 0.0f, 1.0f) * static_cast<GLfloat>(maxDepth));
+
+    std::uint64_t state = field(program, PROGRAM_BITS) << (MATERIAL_BITS + VERTEX_ARRAY_BITS) |
+                          field(material, MATERIAL_BITS) << VERTEX_ARRAY_BITS | field(vertexArray, VERTEX_ARRAY_BITS);
+    std::uint64_t key = field(pass, PASS_BITS) << 1 | (translucent ? 1 : 0);
+
+    if (translucent) return (key << DEPTH_BITS | (maxDepth - quantised)) << stateBits | state;
+    return (key << stateBits | state) << DEPTH_BITS | quantised;
+}
+
+void RenderQueue::push(GpuPass pass, Object &object, const Material &material, GLfloat depth, bool translucent)
+{
+    Geometry* geometry = object.geometry();
+    GLuint vertexArray = geometry ? geometry->pool.VAO : 0;
+
+    packets.push_back({makeKey(pass, translucent, object.shader()->ID, material.id, vertexArray, depth), &object,
+                       &material});
+}
+
+void RenderQueue::sort()
+{
+    PROFILE_SCOPE("RenderQueue::sort");
+
+    unsorted = countChanges(packets);
+    radixSort(packets, scratch);
+}
+
+void RenderQueue::submit(GpuTimer* timer)
+{
+    PROFILE_SCOPE("RenderQueue::submit");
+
+    submitted = {};
+    batches = batchedDraws = 0;
+    auto pass = PASS_COUNT;
+    const Shader* shader = nullptr;
+    const Material* material = nullptr;
+    const GeometryPool* pool = nullptr;
+    Uniform<bool> hasTexture;
+
+    for (size_t i = 0; i < packets.size();)
+    {
+        const DrawPacket &packet = packets[i];
+        auto packetPass = static_cast<GpuPass>(packet.key >> (64 - PASS_BITS));
+        if (packetPass != pass)
+        {
+            if (timer && pass != PASS_COUNT) timer->end(pass);
+            pass = packetPass;
+            if (timer) timer->begin(pass);
+        }
+
+        Geometry* geometry = packet.object->geometry();
+        auto renderer = indirect.find(packet.object->shader().get());
+        bool batched = geometry && renderer != indirect.end();
+
+        const Shader &program = batched ? *renderer->second->shader : *packet.object->shader();
+        if (&program != shader)
+        {
+            program.use();
+            shader = &program;
+            hasTexture = hasTextureUniform(program);
+            material = nullptr;
+            ++submitted.programs;
+        }
+
+        if (packet.material != material)
+        {
+            packet.material->apply(program, hasTexture);
+            material = packet.material;
+            ++submitted.materials;
+        }
+
+        if (geometry && &geometry->pool != pool)
+        {
+            geometry->pool.bind();
+            pool = &geometry->pool;
+            ++submitted.vertexArrays;
+        }
+
+        if (batched)
+        {
+            size_t last = i + 1;
+            while (last < packets.size() && batchable(packet, packets[last])) ++last;
+
+            renderer->second->draw(std::span(packets).subspan(i, last - i), &JobSystem::get());
+            ++batches;
+            batchedDraws += static_cast<GLuint>(last - i);
+
+            i = last;
+            continue;
+        }
+
+        packet.object->draw();
+
+        // Multi-mesh models bind their own textures and arrays, so nothing can be assumed afterwards.
+        if (!geometry)
+        {
+            material = nullptr;
+            pool = nullptr;
+        }
+        ++i;
+    }
+
+    if (timer && pass != PASS_COUNT) timer->end(pass);
+}
+
+void RenderQueue::clear()
+{
+    packets.clear();
+}
+
+void RenderQueue::setIndirect(const Shader &shader, IndirectRenderer* renderer)
+{
+    if (renderer) indirect[&shader] = renderer;
+    else indirect.erase(&shader);
+}
+
+Uniform<bool> RenderQueue::hasTextureUniform(const Shader &shader)
+{
+    auto it = hasTextureUniforms.find(&shader);
+    if (it == hasTextureUniforms.end())
+        it = hasTextureUniforms.emplace(&shader, shader.getUniform<bool>("hasTexture")).first;
+
+    return it->second;
+}
+
+bool RenderQueue::batchable(const DrawPacket &first, const DrawPacket &packet)
+{
+    if (packet.key >> (64 - PASS_BITS) != first.key >> (64 - PASS_BITS)) return false;
+    if (packet.material != first.material || packet.object->shader() != first.object->shader()) return false;
+
+    const Geometry* a = first.object->geometry();
+    const Geometry* b = packet.object->geometry();
+    return b && &a->pool == &b->pool && a->mode == b->mode;
+}
+
+StateChanges RenderQueue::countChanges(std::span<const DrawPacket> packets)
+{
+    StateChanges changes;
+    const Shader* shader = nullptr;
+    const Material* material = nullptr;
+    const GeometryPool* pool = nullptr;
+
+    for (const auto &packet: packets)
+    {
+        const Shader* packetShader = packet.object->shader().get();
+        if (packetShader != shader)
+        {
+            shader = packetShader;
+            material = nullptr;
+            ++changes.programs;
+        }
+
+        if (packet.material != material)
+        {
+            material = packet.material;
+            ++changes.materials;
+        }
+
+        Geometry* geometry = packet.object->geometry();
+        if (geometry && &geometry->pool != pool)
+        {
+            pool = &geometry->pool;
+            ++changes.vertexArrays;
+        }
+        if (!geometry)
+        {
+            material = nullptr;
+            pool = nullptr;
+        }
+    }
+
+    return changes;
+}
+
+void RenderQueue::radixSort(std::vector<DrawPacket> &packets, std::vector<DrawPacket> &scratch)
+{
+    constexpr GLuint DIGIT_BITS = 8, DIGITS = 64 / DIGIT_BITS, BUCKETS = 1 << DIGIT_BITS;
+
+    std::array<std::array<size_t, BUCKETS>, DIGITS> histograms{};
+    for (const auto &packet: packets)
+        for (GLuint digit = 0; digit < DIGITS; ++digit) ++histograms[digit][packet.key >> (digit * DIGIT_BITS) & 0xFF];
+
+    scratch.resize(packets.size());
+    for (GLuint digit = 0; digit < DIGITS; ++digit)
+    {
+        auto &histogram = histograms[digit];
+        if (std::ranges::find(histogram, packets.size()) != histogram.end()) continue;
+
+        size_t offset = 0;
+        for (auto &count: histogram) offset += std::exchange(count, offset);
+
+        for (const auto &packet: packets) scratch[histogram[packet.key >> (digit * DIGIT_BITS) & 0xFF]++] = packet;
+        packets.swap(scratch);
+    }
+}
@@ -0,0 +1,58 @@
+#include "include/resources.h"
+
+std::shared_ptr<Shader> ResourceManager::getShader(const std::string &vertexPath, const std::string &fragmentPath)
+{
+    return getOrLoad(shaders, vertexPath + '|' + fragmentPath, [&]
+    {
+        return std::make_shared<Shader>(vertexPath.c_str(), fragmentPath.c_str());
+    });
+}
+
+std::shared_ptr<Shader> ResourceManager::getComputeShader(const std::string &computePath)
+{
+    return getOrLoad(shaders, computePath, [&] { return std::make_shared<Shader>(computePath.c_str()); });
+}
+
+std::shared_ptr<Texture> ResourceManager::getTexture(const std::string &path, const std::string &type)
+{
+    return getOrLoad(textures, path + '|' + type, [&] { return std::make_shared<Texture>(path.c_str(), type); });
+}
+
+std::shared_ptr<Texture> ResourceManager::getTextureAsync(const std::string &path, const std::string &type)
+{
+    return getOrLoad(textures, path + '|' + type, [&] { return textureLoader.load(path, type); });
+}
+
+std::shared_ptr<Model> ResourceManager::getModel(const std::string &path, const std::shared_ptr<Shader> &shader,
+                                                 GLuint importFlags)
+{
+    std::string key = path + '|' + std::to_string(importFlags) + '|' + std::to_string(shader->ID);
+    return getOrLoad(models, key, [&] { return std::make_shared<Model>(path.c_str(), shader, importFlags); });
+}
+
+void ResourceManager::update() { textureLoader.update(); }
+void ResourceManager::waitForTextures() { textureLoader.waitAll(); }
+
+size_t ResourceManager::textureMemory() const
+{
+    size_t bytes = 0;
+    for (const auto &[key, texture]: textures) bytes += texture->memory();
+
+    return bytes;
+}
+
+void ResourceManager::purgeUnused()
+{
+    purge(models);
+    purge(textures);
+    purge(shaders);
+}
+
+void ResourceManager::clear()
+{
+    textureLoader.release();
+    models.clear();
+    textures.clear();
+    shaders.clear();
+    GeometryPool::releaseAll();
+}
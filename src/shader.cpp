@@ -1,73 +1,91 @@
 #include "include/shader.h"
+#include "include/glstate.h"
+#include "include/profiler.h"
 
 Shader::Shader(const GLchar* vertexPath, const GLchar* fragmentPath)
 {
-    std::ifstream vertexShaderFile;
-    vertexShaderFile.open(vertexPath);
-    if (!vertexShaderFile.is_open())
+    PROFILE_SCOPE("Shader::Shader");
+
+    std::string vertexShaderCode, fragmentShaderCode;
+    if (!readSource(vertexPath, "vertex", vertexShaderCode) ||
+        !readSource(fragmentPath, "fragment", fragmentShaderCode))
+        return;
+
+    GLuint vertexShader = compile(GL_VERTEX_SHADER, vertexShaderCode, "vertex");
+    if (!vertexShader) return;
+
+    GLuint fragmentShader = compile(GL_FRAGMENT_SHADER, fragmentShaderCode, "fragment");
+    if (!fragmentShader)
     {
-        std::cerr << "Failed to open vertex shader file!" << std::endl;
+        glDeleteShader(vertexShader);
         return;
     }
 
-    std::stringstream vertexShaderStream;
-    vertexShaderStream << vertexShaderFile.rdbuf();
-    vertexShaderFile.close();
+    link({vertexShader, fragmentShader});
+}
+
+Shader::Shader(const GLchar* computePath)
+{
+    PROFILE_SCOPE("Shader::Shader");
 
-    std::string vertexShaderCode = vertexShaderStream.str();
-    const GLchar* vertexShaderSource = vertexShaderCode.c_str();
+    std::string computeShaderCode;
+    if (!readSource(computePath, "compute", computeShaderCode)) return;
 
-    std::ifstream fragmentShaderFile;
-    fragmentShaderFile.open(fragmentPath);
-    if (!fragmentShaderFile.is_open())
+    GLuint computeShader = compile(GL_COMPUTE_SHADER, computeShaderCode, "compute");
+    if (computeShader) link({computeShader});
+}
+
+bool Shader::readSource(const GLchar* path, const GLchar* stage, std::string &source)
+{
+    std::ifstream file;
+    file.open(path);
+    if (!file.is_open())
     {
-        std::cerr << "Failed to open fragment shader file!" << std::endl;
-        return;
+        std::cerr << "Failed to open " << stage << " shader file!" << std::endl;
+        return false;
     }
 
-    std::stringstream fragmentShaderStream;
-    fragmentShaderStream << fragmentShaderFile.rdbuf();
-    fragmentShaderFile.close();
+    std::stringstream stream;
+    stream << file.rdbuf();
+    file.close();
 
-    std::string fragmentShaderCode = fragmentShaderStream.str();
-    const GLchar* fragmentShaderSource = fragmentShaderCode.c_str();
+    source = stream.str();
+    return true;
+}
 
-    GLuint vertexShader, fragmentShader;
+GLuint Shader::compile(GLenum type, const std::string &source, const GLchar* stage)
+{
+    const GLchar* shaderSource = source.c_str();
     GLint success;
     GLchar infoLog[512];
 
-    vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &vertexShaderSource, nullptr);
-    glCompileShader(vertexShader);
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &shaderSource, nullptr);
+    glCompileShader(shader);
 
-    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
     if (!success)
     {
-        glGetShaderInfoLog(vertexShader, 512, nullptr, infoLog);
-        std::cerr << "Failed to compile vertex shader!" << std::endl;
+        glGetShaderInfoLog(shader, 512, nullptr, infoLog);
+        std::cerr << "Failed to compile " << stage << " shader!" << std::endl;
         std::cerr << infoLog << std::endl;
 
-        return;
+        glDeleteShader(shader);
+        return 0;
     }
 
-    fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, nullptr);
-    glCompileShader(fragmentShader);
-
-    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-    if (!success)
-    {
-        glGetShaderInfoLog(fragmentShader, 512, nullptr, infoLog);
-        std::cerr << "Failed to compile fragment shader!" << std::endl;
-        std::cerr << infoLog << std::endl;
+    return shader;
+}
 
-        return;
-    }
+void Shader::link(std::initializer_list<GLuint> stages)
+{
+    GLint success;
+    GLchar infoLog[512];
 
     ID = glCreateProgram();
-    glAttachShader(ID, vertexShader);
-    glAttachShader(ID, fragmentShader);
+    for (GLuint stage: stages) glAttachShader(ID, stage);
     glLinkProgram(ID);
+    for (GLuint stage: stages) glDeleteShader(stage);
 
     glGetProgramiv(ID, GL_LINK_STATUS, &success);
     if (!success)
@@ -79,55 +97,66 @@ Shader::Shader(const GLchar* vertexPath, const GLchar* fragmentPath)
         return;
     }
 
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+    reflectUniforms();
+    bindUniformBlocks();
 }
 
-Shader::~Shader() { glDeleteProgram(ID); }
-void Shader::use() const { glUseProgram(ID); }
-
-void Shader::setMatrices(glm::mat4 view, glm::mat4 projection) const
+Shader::~Shader()
 {
-    glm::mat4 modelMatrix = glm::mat4(1.0f);
-    modelMatrix = glm::translate(modelMatrix, glm::vec3(0.0f, 0.0f, 0.0f));
-    modelMatrix = glm::rotate(modelMatrix, glm::radians(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-
-    setMat4("model", modelMatrix);
-    setMat4("view", view);
-    setMat4("projection", projection);
+    GLState::forgetProgram(ID);
+    glDeleteProgram(ID);
 }
 
-void Shader::setBool(const std::string &name, bool value) const
-{
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), static_cast<GLint>(value));
-}
+void Shader::use() const { GLState::useProgram(ID); }
 
-void Shader::setInt(const std::string &name, GLint value) const
+void Shader::reflectUniforms()
 {
-    glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
-}
+    GLint count = 0, maxLength = 0;
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
 
-void Shader::setFloat(const std::string &name, GLfloat value) const
-{
-    glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
-}
+    std::string name(static_cast<size_t>(maxLength), '\0');
+    uniforms.reserve(count);
 
-void Shader::setVec2(const std::string &name, glm::vec2 value) const
-{
-    glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, glm::value_ptr(value));
+    for (GLint i = 0; i < count; ++i)
+    {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+
+        glGetActiveUniform(ID, static_cast<GLuint>(i), maxLength, &length, &size, &type, name.data());
+        std::string uniformName = name.substr(0, length);
+
+        GLint location = glGetUniformLocation(ID, uniformName.c_str());
+        if (location < 0) continue;
+
+        if (uniformName.ends_with("[0]")) uniformName.resize(uniformName.size() - 3);
+        uniforms.push_back({uniformName, location, size, type});
+    }
 }
 
-void Shader::setVec3(const std::string &name, glm::vec3 value) const
+void Shader::bindUniformBlock(const GLchar* name, GLuint binding) const
 {
-    glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, glm::value_ptr(value));
+    GLuint blockIndex = glGetUniformBlockIndex(ID, name);
+    if (blockIndex != GL_INVALID_INDEX) glUniformBlockBinding(ID, blockIndex, binding);
 }
 
-void Shader::setVec4(const std::string &name, glm::vec4 value) const
+void Shader::bindUniformBlocks() const
 {
-    glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, glm::value_ptr(value));
+    bindUniformBlock("Frame", FRAME_BLOCK_BINDING);
+    bindUniformBlock("Light", LIGHT_BLOCK_BINDING);
 }
 
-void Shader::setMat4(const std::string &name, glm::mat4 value) const
+GLint Shader::findUniform(std::string_view name) const
 {
-    glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, glm::value_ptr(value));
+    for (size_t i = 0; i < uniforms.size(); ++i) if (uniforms[i].name == name) return static_cast<GLint>(i);
+    return -1;
 }
+
+void Shader::setBool(std::string_view name, bool value) const { set(getUniform<bool>(name), value); }
+void Shader::setInt(std::string_view name, GLint value) const { set(getUniform<GLint>(name), value); }
+void Shader::setFloat(std::string_view name, GLfloat value) const { set(getUniform<GLfloat>(name), value); }
+void Shader::setVec2(std::string_view name, glm::vec2 value) const { set(getUniform<glm::vec2>(name), value); }
+void Shader::setVec3(std::string_view name, glm::vec3 value) const { set(getUniform<glm::vec3>(name), value); }
+void Shader::setVec4(std::string_view name, glm::vec4 value) const { set(getUniform<glm::vec4>(name), value); }
+void Shader::setMat4(std::string_view name, glm::mat4 value) const { set(getUniform<glm::mat4>(name), value); }
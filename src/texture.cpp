@@ -1,12 +1,13 @@
 #include "include/texture.h"
+#include "include/glstate.h"
+#include "include/meshcache.h"
+#include "include/profiler.h"
+#include "include/texturecache.h"
 
-Texture::Texture(const GLchar* file, const std::string &type)
+Texture::Texture(std::string file, std::string type, bool placeholder) : type(std::move(type)), path(std::move(file))
 {
-    this->type = type;
-    path = file;
-
     glGenTextures(1, &id);
-    glBindTexture(GL_TEXTURE_2D, id);
+    GLState::bindTexture(0, GL_TEXTURE_2D, id);
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -14,38 +15,226 @@ Texture::Texture(const GLchar* file, const std::string &type)
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-    int width, height, numChannels;
-    unsigned char* data = stbi_load(file, &width, &height, &numChannels, 0);
-    if (data)
+    if (placeholder)
+    {
+        const unsigned char white[4] = {255, 255, 255, 255};
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
+    }
+}
+
+Texture::Texture(const GLchar* file, const std::string &type) : Texture(file, type, false)
+{
+    PROFILE_SCOPE("Texture::Texture");
+
+    DecodedImage image = decodeImage(file, type);
+    if (image.compressed.valid()) uploadCompressed(image.compressed, image.compressed.data.data());
+    else if (image.pixels) upload(image.width, image.height, image.numChannels, image.pixels.get());
+}
+
+Texture::~Texture()
+{
+    GLState::forgetTexture(id);
+    glDeleteTextures(1, &id);
+}
+
+std::shared_ptr<Texture> Texture::createPlaceholder(const GLchar* file, const std::string &type)
+{
+    return std::shared_ptr<Texture>(new Texture(file, type, true));
+}
+
+void Texture::bind(GLuint textureUnit) const
+{
+    GLState::bindTexture(textureUnit - GL_TEXTURE0, GL_TEXTURE_2D, id);
+}
+
+void Texture::upload(GLint width, GLint height, GLint numChannels, const void* pixels)
+{
+    GLenum format = 0;
+    switch (numChannels)
+    {
+        case 1:
+            format = GL_RED;
+            break;
+        case 3:
+            format = GL_RGB;
+            break;
+        case 4:
+            format = GL_RGBA;
+            break;
+        default:
+            std::cerr << "Invalid number of channels (" << numChannels << ") in texture \"" << path << "\""
+                      << std::endl;
+            return;
+    }
+
+    GLState::bindTexture(0, GL_TEXTURE_2D, id);
+    glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(format), width, height, 0, format, GL_UNSIGNED_BYTE, pixels);
+    glGenerateMipmap(GL_TEXTURE_2D);
+
+    bytes = static_cast<size_t>(width) * height * numChannels * 4 / 3;
+    ready = true;
+}
+
+void Texture::uploadCompressed(const CompressedImage &image, const std::byte* data)
+{
+    GLState::bindTexture(0, GL_TEXTURE_2D, id);
+    for (size_t level = 0; level < image.levels.size(); ++level)
+    {
+        const CompressedLevel &source = image.levels[level];
+        const void* pixels = data ? static_cast<const void*>(data + source.offset)
+                                  : reinterpret_cast<const void*>(source.offset);
+
+        glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), BLOCK_FORMAT_GL[image.format], source.width,
+                               source.height, 0, static_cast<GLsizei>(source.size), pixels);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(image.levels.size()) - 1);
+
+    if (image.format == BLOCK_BC4)
+    {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_G, GL_RED);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_B, GL_RED);
+    }
+
+    bytes = image.data.size();
+    ready = true;
+}
+
+DecodedImage decodeImage(const std::string &file, const std::string &type)
+{
+    PROFILE_SCOPE("decodeImage");
+
+    DecodedImage image;
+    std::string cachePath;
+    std::uint64_t sourceHash = 0;
+    BlockFormat format = BLOCK_BC1;
+
+    if (Texture::compression && stbi_info(file.c_str(), &image.width, &image.height, &image.numChannels))
+    {
+        format = chooseBlockFormat(file, type, image.numChannels);
+        if (blockFormatSupported(format))
+        {
+            cachePath = TextureCache::pathFor(file);
+            sourceHash = MeshCache::hashFile(file);
+
+            if (auto cached = TextureCache::read(cachePath, sourceHash, format))
+            {
+                image.compressed = std::move(*cached);
+                return image;
+            }
+        }
+    }
+
+    image.pixels.reset(stbi_load(file.c_str(), &image.width, &image.height, &image.numChannels, 0));
+    if (!image.pixels)
+    {
+        std::cerr << "Failed to load texture from file \"" << file << "\": " << stbi_failure_reason() << std::endl;
+        return image;
+    }
+
+    if (!cachePath.empty())
+    {
+        image.compressed = compressImage(image.pixels.get(), image.width, image.height, image.numChannels, format,
+                                         &JobSystem::get());
+        TextureCache::write(cachePath, sourceHash, image.compressed);
+        if (image.compressed.valid()) image.pixels.reset();
+    }
+
+    return image;
+}
+
+std::shared_ptr<Texture> TextureLoader::load(const std::string &file, const std::string &type)
+{
+    auto promise = std::make_shared<std::promise<DecodedImage>>();
+    Request &request = pending.emplace_back(Request{Texture::createPlaceholder(file.c_str(), type),
+                                                    promise->get_future()});
+
+    JobSystem::get().submit([promise, file, type]
     {
-        GLenum format = 0;
-        switch (numChannels)
+        PROFILE_SCOPE("TextureLoader::decode");
+
+        promise->set_value(decodeImage(file, type));
+    });
+
+    return request.texture;
+}
+
+void TextureLoader::update(GLuint maxUploads)
+{
+    PROFILE_SCOPE("TextureLoader::update");
+
+    GLuint uploads = 0;
+    for (auto it = pending.begin(); it != pending.end() && uploads < maxUploads;)
+    {
+        if (it->image.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
         {
-            case 1:
-                format = GL_RED;
-                break;
-            case 3:
-                format = GL_RGB;
-                break;
-            case 4:
-                format = GL_RGBA;
-                break;
-            default:
-                std::cerr << "Invalid number of channels (" << numChannels << ") in texture \"" << file << "\""
-                          << std::endl;
-                break;
+            ++it;
+            continue;
         }
 
-        glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(format), width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-    } else std::cerr << "Failed to load texture from file \"" << file << "\": " << stbi_failure_reason() << std::endl;
+        upload(*it);
+        it = pending.erase(it);
+        ++uploads;
+    }
+}
+
+void TextureLoader::wait(const std::shared_ptr<Texture> &texture)
+{
+    auto it = std::find_if(pending.begin(), pending.end(), [&](const Request &request)
+    {
+        return request.texture == texture;
+    });
+    if (it == pending.end()) return;
 
-    stbi_image_free(data);
+    upload(*it);
+    pending.erase(it);
 }
 
-Texture::~Texture() { glDeleteTextures(1, &id); }
-void Texture::bind(GLuint textureUnit) const
+void TextureLoader::waitAll()
+{
+    for (auto &request: pending) upload(request);
+    pending.clear();
+}
+
+void TextureLoader::release()
+{
+    pending.clear();
+
+    GLState::forgetBuffer(pixelBuffer);
+    glDeleteBuffers(1, &pixelBuffer);
+    pixelBuffer = 0;
+}
+
+void TextureLoader::upload(Request &request)
 {
-    glActiveTexture(textureUnit);
-    glBindTexture(GL_TEXTURE_2D, id);
+    PROFILE_SCOPE("TextureLoader::upload");
+
+    DecodedImage image = request.image.get();
+    bool compressed = image.compressed.valid();
+    if (!compressed && !image.pixels) return;
+
+    auto size = compressed ? static_cast<GLsizeiptr>(image.compressed.data.size())
+                           : static_cast<GLsizeiptr>(image.width) * image.height * image.numChannels;
+    const void* source = compressed ? static_cast<const void*>(image.compressed.data.data()) : image.pixels.get();
+    if (!pixelBuffer) glGenBuffers(1, &pixelBuffer);
+
+    GLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+
+    void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+                                    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (mapped)
+    {
+        std::memcpy(mapped, source, static_cast<size_t>(size));
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+        if (compressed) request.texture->uploadCompressed(image.compressed, nullptr);
+        else
+        {
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            request.texture->upload(image.width, image.height, image.numChannels, nullptr);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        }
+    }
+
+    GLState::bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
 }
@@ -0,0 +1,209 @@
+#include "include/texturecache.h"
+#include "include/meshcache.h"
+#include "include/profiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+    enum DescriptorModel : std::uint32_t
+    {
+        MODEL_BC1A = 128,
+        MODEL_BC3 = 130,
+        MODEL_BC4 = 131,
+        MODEL_BC5 = 132
+    };
+
+    constexpr std::uint32_t PRIMARIES_BT709 = 1, TRANSFER_LINEAR = 1, CHANNEL_ALPHA = 15;
+
+    std::vector<std::uint32_t> dataFormatDescriptor(BlockFormat format)
+    {
+        struct Sample
+        {
+            std::uint32_t bitOffset, channel;
+        };
+
+        std::vector<Sample> samples;
+        DescriptorModel model;
+        switch (format)
+        {
+            case BLOCK_BC1:
+                model = MODEL_BC1A;
+                samples = {{0, 0}};
+                break;
+            case BLOCK_BC3:
+                model = MODEL_BC3;
+                samples = {{0, CHANNEL_ALPHA}, {64, 0}};
+                break;
+            case BLOCK_BC4:
+                model = MODEL_BC4;
+                samples = {{0, 0}};
+                break;
+            default:
+                model = MODEL_BC5;
+                samples = {{0, 0}, {64, 1}};
+                break;
+        }
+
+        auto blockSize = static_cast<std::uint32_t>(24 + 16 * samples.size());
+        std::vector<std::uint32_t> words = {4 + blockSize, 0, 2 | blockSize << 16,
+                                            model | PRIMARIES_BT709 << 8 | TRANSFER_LINEAR << 16, 3 | 3 << 8,
+                                            BLOCK_FORMAT_BYTES[format], 0};
+        for (const auto &sample: samples)
+            words.insert(words.end(), {sample.bitOffset | 63 << 16 | sample.channel << 24, 0, 0, 0xFFFFFFFF});
+
+        return words;
+    }
+
+    std::uint64_t align(std::uint64_t offset) { return (offset + 15) & ~static_cast<std::uint64_t>(15); }
+}
+
+std::string TextureCache::pathFor(const std::string &sourcePath) { return sourcePath + ".ktx2"; }
+
+std::optional<CompressedImage> TextureCache::read(const std::string &path, std::uint64_t sourceHash,
+                                                  BlockFormat format)
+{
+    PROFILE_SCOPE("TextureCache::read");
+
+    MappedFile file(path);
+    if (!file.isOpen() || file.size() < sizeof(Header)) return std::nullopt;
+
+    Header header;
+    std::memcpy(&header, file.bytes(), sizeof(Header));
+    if (!std::equal(IDENTIFIER.begin(), IDENTIFIER.end(), header.identifier) ||
+        header.vkFormat != VK_FORMATS[format] || header.supercompressionScheme != 0 || header.faceCount != 1 ||
+        header.levelCount == 0 || sizeof(Header) + header.levelCount * sizeof(LevelIndex) > file.size() ||
+        static_cast<std::uint64_t>(header.kvdByteOffset) + header.kvdByteLength > file.size())
+        return std::nullopt;
+
+    bool matches = false;
+    for (std::uint32_t offset = header.kvdByteOffset; offset + 4 <= header.kvdByteOffset + header.kvdByteLength;)
+    {
+        std::uint32_t length;
+        std::memcpy(&length, file.bytes() + offset, 4);
+        if (offset + 4 + static_cast<std::uint64_t>(length) > header.kvdByteOffset + header.kvdByteLength) break;
+
+        const auto* entry = reinterpret_cast<const GLchar*>(file.bytes() + offset + 4);
+        size_t keyLength = std::strlen(METADATA_KEY) + 1;
+        if (length == keyLength + sizeof(Metadata) && std::memcmp(entry, METADATA_KEY, keyLength) == 0)
+        {
+            Metadata metadata;
+            std::memcpy(&metadata, entry + keyLength, sizeof(Metadata));
+            matches = metadata.sourceHash == sourceHash && metadata.version == VERSION && metadata.format == format;
+        }
+
+        offset += 4 + (length + 3) / 4 * 4;
+    }
+    if (!matches) return std::nullopt;
+
+    CompressedImage image;
+    image.format = format;
+
+    for (std::uint32_t level = 0; level < header.levelCount; ++level)
+    {
+        LevelIndex index;
+        std::memcpy(&index, file.bytes() + sizeof(Header) + level * sizeof(LevelIndex), sizeof(LevelIndex));
+
+        GLint width = std::max(1, static_cast<GLint>(header.pixelWidth >> level));
+        GLint height = std::max(1, static_cast<GLint>(header.pixelHeight >> level));
+        size_t size = static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * BLOCK_FORMAT_BYTES[format];
+        if (index.byteLength != size || index.byteOffset + index.byteLength > file.size()) return std::nullopt;
+
+        image.levels.push_back({width, height, image.data.size(), size});
+        image.data.insert(image.data.end(), reinterpret_cast<const std::byte*>(file.bytes() + index.byteOffset),
+                          reinterpret_cast<const std::byte*>(file.bytes() + index.byteOffset + size));
+    }
+
+    return image;
+}
+
+bool TextureCache::write(const std::string &path, std::uint64_t sourceHash, const CompressedImage &image)
+{
+    PROFILE_SCOPE("TextureCache::write");
+
+    if (!image.valid()) return false;
+
+    std::vector<std::uint32_t> descriptor = dataFormatDescriptor(image.format);
+    Metadata metadata = {sourceHash, VERSION, static_cast<std::uint32_t>(image.format)};
+    size_t keyLength = std::strlen(METADATA_KEY) + 1;
+    auto entryLength = static_cast<std::uint32_t>(keyLength + sizeof(Metadata));
+
+    std::vector<std::uint8_t> keyValues(4 + (entryLength + 3) / 4 * 4);
+    std::memcpy(keyValues.data(), &entryLength, 4);
+    std::memcpy(keyValues.data() + 4, METADATA_KEY, keyLength);
+    std::memcpy(keyValues.data() + 4 + keyLength, &metadata, sizeof(Metadata));
+
+    auto levelCount = static_cast<std::uint32_t>(image.levels.size());
+    auto dfdOffset = static_cast<std::uint32_t>(sizeof(Header) + levelCount * sizeof(LevelIndex));
+    auto dfdLength = static_cast<std::uint32_t>(descriptor.size() * sizeof(std::uint32_t));
+    auto kvdOffset = dfdOffset + dfdLength;
+    auto kvdLength = static_cast<std::uint32_t>(keyValues.size());
+
+    // Level images are stored smallest first, while the index lists them from the base level down.
+    std::vector<LevelIndex> levels(levelCount);
+    std::uint64_t offset = align(kvdOffset + kvdLength);
+    for (auto level = levelCount; level-- > 0;)
+    {
+        levels[level] = {offset, image.levels[level].size, image.levels[level].size};
+        offset = align(offset + image.levels[level].size);
+    }
+
+    Header header = {};
+    std::copy(IDENTIFIER.begin(), IDENTIFIER.end(), header.identifier);
+    header.vkFormat = VK_FORMATS[image.format];
+    header.typeSize = 1;
+    header.pixelWidth = static_cast<std::uint32_t>(image.levels.front().width);
+    header.pixelHeight = static_cast<std::uint32_t>(image.levels.front().height);
+    header.faceCount = 1;
+    header.levelCount = levelCount;
+    header.dfdByteOffset = dfdOffset;
+    header.dfdByteLength = dfdLength;
+    header.kvdByteOffset = kvdOffset;
+    header.kvdByteLength = kvdLength;
+
+    std::string temporaryPath = path + ".tmp";
+    std::ofstream output(temporaryPath, std::ios::binary | std::ios::trunc);
+    if (!output.is_open())
+    {
+        std::cerr << "Failed to write texture cache \"" << path << "\"" << std::endl;
+        return false;
+    }
+
+    auto pad = [&]
+    {
+        static const GLchar zeros[16] = {};
+        auto position = static_cast<std::uint64_t>(output.tellp());
+        output.write(zeros, static_cast<std::streamsize>(align(position) - position));
+    };
+
+    output.write(reinterpret_cast<const GLchar*>(&header), sizeof(header));
+    output.write(reinterpret_cast<const GLchar*>(levels.data()),
+                 static_cast<std::streamsize>(levels.size() * sizeof(LevelIndex)));
+    output.write(reinterpret_cast<const GLchar*>(descriptor.data()), dfdLength);
+    output.write(reinterpret_cast<const GLchar*>(keyValues.data()), kvdLength);
+    pad();
+
+    for (auto level = levelCount; level-- > 0;)
+    {
+        output.write(reinterpret_cast<const GLchar*>(image.data.data() + image.levels[level].offset),
+                     static_cast<std::streamsize>(image.levels[level].size));
+        pad();
+    }
+
+    output.close();
+    std::remove(path.c_str());
+    if (!output || std::rename(temporaryPath.c_str(), path.c_str()) != 0)
+    {
+        std::cerr << "Failed to write texture cache \"" << path << "\"" << std::endl;
+        std::remove(temporaryPath.c_str());
+
+        return false;
+    }
+
+    return true;
+}
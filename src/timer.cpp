@@ -0,0 +1,96 @@
+#include "include/timer.h"
+
+GpuTimer::GpuTimer()
+{
+    for (auto &frame: ring) glGenQueries(static_cast<GLsizei>(frame.queries.size()), frame.queries.data());
+}
+
+GpuTimer::~GpuTimer()
+{
+    for (auto &frame: ring) glDeleteQueries(static_cast<GLsizei>(frame.queries.size()), frame.queries.data());
+}
+
+void GpuTimer::beginFrame()
+{
+    FrameQueries &frame = current();
+    if (frame.pending && !resolve(frame, false))
+    {
+        frame.pending = false;
+        ++dropped;
+    }
+
+    frame.frame = frameIndex;
+    frame.issued.fill(false);
+    glQueryCounter(frame.queries[0], GL_TIMESTAMP);
+}
+
+void GpuTimer::endFrame()
+{
+    FrameQueries &frame = current();
+    glQueryCounter(frame.queries[1], GL_TIMESTAMP);
+    frame.pending = true;
+    ++frameIndex;
+
+    for (GLuint64 age = LATENCY; age > 0; --age)
+    {
+        FrameQueries &previous = ring[(frameIndex + LATENCY - age) % LATENCY];
+        if (previous.pending && !resolve(previous, false)) break;
+    }
+}
+
+void GpuTimer::begin(GpuPass pass)
+{
+    FrameQueries &frame = current();
+    frame.issued[pass] = true;
+    glQueryCounter(frame.queries[2 + pass * 2], GL_TIMESTAMP);
+}
+
+void GpuTimer::end(GpuPass pass) { glQueryCounter(current().queries[3 + pass * 2], GL_TIMESTAMP); }
+
+void GpuTimer::flush()
+{
+    for (GLuint64 age = LATENCY; age > 0; --age)
+    {
+        FrameQueries &frame = ring[(frameIndex + LATENCY - age) % LATENCY];
+        if (frame.pending) resolve(frame, true);
+    }
+}
+
+std::vector<GpuFrameTimings> GpuTimer::takeCompleted()
+{
+    std::vector<GpuFrameTimings> result;
+    result.swap(completed);
+
+    return result;
+}
+
+bool GpuTimer::resolve(FrameQueries &frame, bool wait)
+{
+    if (!wait)
+    {
+        GLint available = 0;
+        glGetQueryObjectiv(frame.queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) return false;
+    }
+
+    auto elapsed = [&](GLuint begin)
+    {
+        GLuint64 start = 0, stop = 0;
+        glGetQueryObjectui64v(frame.queries[begin], GL_QUERY_RESULT, &start);
+        glGetQueryObjectui64v(frame.queries[begin + 1], GL_QUERY_RESULT, &stop);
+
+        return static_cast<GLdouble>(stop - start) / 1.0e6;
+    };
+
+    GpuFrameTimings timings;
+    timings.frame = frame.frame;
+    timings.total = elapsed(0);
+    for (GLuint pass = 0; pass < PASS_COUNT; ++pass)
+        if (frame.issued[pass]) timings.passes[pass] = elapsed(2 + pass * 2);
+
+    frame.pending = false;
+    latestTimings = timings;
+    if (recording) completed.push_back(timings);
+
+    return true;
+}
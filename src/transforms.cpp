@@ -0,0 +1,209 @@
+#include "include/transforms.h"
+#include "include/profiler.h"
+
+#include <cmath>
+#include <iostream>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TRANSFORMS_SSE
+#include <emmintrin.h>
+#endif
+
+glm::mat4 composeTransform(const glm::vec3 &position, const glm::vec3 &rotation, const glm::vec3 &scale)
+{
+    GLfloat sx = std::sin(glm::radians(rotation.x)), cx = std::cos(glm::radians(rotation.x));
+    GLfloat sy = std::sin(glm::radians(rotation.y)), cy = std::cos(glm::radians(rotation.y));
+    GLfloat sz = std::sin(glm::radians(rotation.z)), cz = std::cos(glm::radians(rotation.z));
+
+    glm::mat4 result(1.0f);
+    result[0] = glm::vec4(cy * cz, sx * sy * cz + cx * sz, -cx * sy * cz + sx * sz, 0.0f) * scale.x;
+    result[1] = glm::vec4(-cy * sz, -sx * sy * sz + cx * cz, cx * sy * sz + sx * cz, 0.0f) * scale.y;
+    result[2] = glm::vec4(sy, -sx * cy, cx * cy, 0.0f) * scale.z;
+    result[3] = glm::vec4(position, 1.0f);
+
+    return result;
+}
+
+void multiplyTransforms(const glm::mat4 &parent, const glm::mat4 &local, glm::mat4 &result)
+{
+    #if defined(TRANSFORMS_SSE)
+    __m128 p0 = _mm_loadu_ps(&parent[0][0]), p1 = _mm_loadu_ps(&parent[1][0]), p2 = _mm_loadu_ps(&parent[2][0]),
+            p3 = _mm_loadu_ps(&parent[3][0]);
+
+    for (GLint column = 0; column < 4; ++column)
+    {
+        const GLfloat* l = &local[column][0];
+        __m128 sum = _mm_add_ps(_mm_add_ps(_mm_mul_ps(p0, _mm_set1_ps(l[0])), _mm_mul_ps(p1, _mm_set1_ps(l[1]))),
+                                _mm_add_ps(_mm_mul_ps(p2, _mm_set1_ps(l[2])), _mm_mul_ps(p3, _mm_set1_ps(l[3]))));
+        _mm_storeu_ps(&result[column][0], sum);
+    }
+    #else
+    result = parent * local;
+    #endif
+}
+
+TransformHierarchy::Handle TransformHierarchy::create(Handle parent)
+{
+    auto handle = static_cast<Handle>(parents.size());
+
+    parents.push_back(parent);
+    children.emplace_back();
+    if (parent != INVALID_HANDLE) children[parent].push_back(handle);
+
+    slots.push_back(static_cast<GLuint>(handles.size()));
+    handles.push_back(handle);
+    parentSlots.push_back(parent == INVALID_HANDLE ? INVALID_HANDLE : slots[parent]);
+    subtreeEnds.push_back(slots.back() + 1);
+    positions.emplace_back(0.0f);
+    rotations.emplace_back(0.0f);
+    scales.emplace_back(1.0f);
+    locals.emplace_back(1.0f);
+    worlds.emplace_back(1.0f);
+    dirty.push_back(1);
+
+    structureChanged = true;
+    return handle;
+}
+
+void TransformHierarchy::reserve(size_t count)
+{
+    parents.reserve(count);
+    children.reserve(count);
+    slots.reserve(count);
+    handles.reserve(count);
+    parentSlots.reserve(count);
+    subtreeEnds.reserve(count);
+    positions.reserve(count);
+    rotations.reserve(count);
+    scales.reserve(count);
+    locals.reserve(count);
+    worlds.reserve(count);
+    dirty.reserve(count);
+}
+
+void TransformHierarchy::setParent(Handle node, Handle parent)
+{
+    if (parents[node] == parent) return;
+
+    for (Handle ancestor = parent; ancestor != INVALID_HANDLE; ancestor = parents[ancestor])
+    {
+        if (ancestor != node) continue;
+
+        std::cerr << "Ignoring transform parent that would create a cycle" << std::endl;
+        return;
+    }
+
+    if (parents[node] != INVALID_HANDLE) std::erase(children[parents[node]], node);
+    if (parent != INVALID_HANDLE) children[parent].push_back(node);
+
+    parents[node] = parent;
+    dirty[slots[node]] = 1;
+    structureChanged = true;
+}
+
+void TransformHierarchy::setLocal(Handle node, const glm::vec3 &position, const glm::vec3 &rotation,
+                                  const glm::vec3 &scale)
+{
+    GLuint slot = slots[node];
+
+    positions[slot] = position;
+    rotations[slot] = rotation;
+    scales[slot] = scale;
+    dirty[slot] = 1;
+}
+
+void TransformHierarchy::update(JobSystem* jobs)
+{
+    PROFILE_SCOPE("TransformHierarchy::update");
+
+    if (structureChanged) rebuildOrder();
+
+    updatedNodes = 0;
+    auto count = static_cast<GLuint>(handles.size());
+
+    for (GLuint slot = 0; slot < count;)
+    {
+        if (!dirty[slot])
+        {
+            ++slot;
+            continue;
+        }
+
+        updateRange(slot, subtreeEnds[slot], jobs);
+        updatedNodes += subtreeEnds[slot] - slot;
+        slot = subtreeEnds[slot];
+    }
+}
+
+void TransformHierarchy::updateRange(GLuint first, GLuint last, JobSystem* jobs)
+{
+    auto composeLocals = [&](size_t begin, size_t end)
+    {
+        for (size_t slot = first + begin; slot < first + end; ++slot)
+        {
+            if (dirty[slot]) locals[slot] = composeTransform(positions[slot], rotations[slot], scales[slot]);
+            dirty[slot] = 0;
+        }
+    };
+
+    if (jobs && last - first >= PARALLEL_THRESHOLD) jobs->parallelFor(last - first, composeLocals, 1024);
+    else composeLocals(0, last - first);
+
+    for (GLuint slot = first; slot < last; ++slot)
+    {
+        if (parentSlots[slot] == INVALID_HANDLE) worlds[slot] = locals[slot];
+        else multiplyTransforms(worlds[parentSlots[slot]], locals[slot], worlds[slot]);
+    }
+}
+
+void TransformHierarchy::rebuildOrder()
+{
+    PROFILE_SCOPE("TransformHierarchy::rebuildOrder");
+
+    auto count = static_cast<GLuint>(parents.size());
+    std::vector<Handle> order, stack;
+    std::vector<GLuint> orderedSlots(count);
+    order.reserve(count);
+
+    for (Handle root = 0; root < count; ++root)
+    {
+        if (parents[root] != INVALID_HANDLE) continue;
+
+        stack.push_back(root);
+        while (!stack.empty())
+        {
+            Handle node = stack.back();
+            stack.pop_back();
+
+            orderedSlots[node] = static_cast<GLuint>(order.size());
+            order.push_back(node);
+            for (auto child = children[node].rbegin(); child != children[node].rend(); ++child) stack.push_back(*child);
+        }
+    }
+
+    auto permute = [&](auto &values)
+    {
+        std::remove_reference_t<decltype(values)> sorted(values.size());
+        for (GLuint slot = 0; slot < count; ++slot) sorted[slot] = values[slots[order[slot]]];
+        values.swap(sorted);
+    };
+
+    permute(positions);
+    permute(rotations);
+    permute(scales);
+    permute(locals);
+    permute(worlds);
+    permute(dirty);
+
+    slots.swap(orderedSlots);
+    handles = order;
+
+    for (GLuint slot = count; slot-- > 0;)
+    {
+        Handle node = order[slot];
+        parentSlots[slot] = parents[node] == INVALID_HANDLE ? INVALID_HANDLE : slots[parents[node]];
+        subtreeEnds[slot] = children[node].empty() ? slot + 1 : subtreeEnds[slots[children[node].back()]];
+    }
+
+    structureChanged = false;
+}